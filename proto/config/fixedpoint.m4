@@ -0,0 +1,9 @@
+AC_DEFUN([PROTO_WITH_FIXED_POINT], [
+    AC_ARG_ENABLE(fixed-point, [AS_HELP_STRING([--enable-fixed-point], [Use Q16.16 fixed point Numbers in the VM instead of float])])
+
+    if test "x$enable_fixed_point" = xyes; then
+        AC_DEFINE([NUMBER_FIXED_POINT], 1,
+                  [Define to use Q16.16 fixed point Numbers in the VM])
+    fi
+    AM_CONDITIONAL(USE_FIXED_POINT, test "x$enable_fixed_point" = xyes)
+])
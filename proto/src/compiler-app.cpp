@@ -20,8 +20,22 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #define Instruction InstructionX
 #include "DefaultsPlugin.h"
 #undef Instruction
+#if USE_NEOCOMPILER
+#include <deque>
+#include <sstream>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 void run_test_suite(); // testing kludge
+#if USE_NEOCOMPILER
+struct ServerConfig;
+ServerConfig* server_config(int argc, char* argv[]);
+void compile_for_server(NeoCompiler* compiler, const string& program);
+void serve(NeoCompiler* compiler, size_t jobs, const ServerConfig* config);
+#endif
 
 int main (int argc, char *argv[]) {
   post("PROTO v%s%s (Kernel %s) (Developed by MIT Space-Time Programming Group 2005-2008)\n",
@@ -32,6 +46,9 @@ int main (int argc, char *argv[]) {
 		  "[paleo]",
 #endif
 		  KERNEL_VERSION);
+#if USE_NEOCOMPILER
+  ServerConfig* server = server_config(argc,argv);
+#endif
   Args *args = new Args(argc,argv); // set up the arg parser
   plugins.ensure_initialized(args);
   
@@ -44,6 +61,18 @@ int main (int argc, char *argv[]) {
 #endif
 
   if(args->extract_switch("--test")) { run_test_suite(); exit(0); }
+#if USE_NEOCOMPILER
+  if(args->extract_switch("--server")) {
+    int jobs = args->extract_switch("--server-jobs") ? args->pop_int()
+      : sysconf(_SC_NPROCESSORS_ONLN);
+    serve(neocompiler, jobs > 0 ? jobs : 1, server);
+    exit(0);
+  }
+  if(args->extract_switch("--server-compile")) { // a cold server request
+    compile_for_server(neocompiler, args->pop_next());
+    exit(0);
+  }
+#endif
 
   // load the script
   int len;
@@ -80,6 +109,130 @@ int main (int argc, char *argv[]) {
 }
 
 
+#if USE_NEOCOMPILER
+/**
+ * Compile server: the core libraries and plugins are loaded once, then
+ * each request read from stdin is compiled in a forked copy of the warm
+ * compiler, so a failing or state-polluting program cannot affect later
+ * ones.  A request is one line, either just a program (as for --infile),
+ * or tab-separated as
+ *
+ *   <platform> TAB <flags> TAB <program>
+ *
+ * An empty platform or flags field means the server's own.  A request
+ * whose platform and flags both match the server's uses the warm compiler;
+ * any other is compiled by a fresh p2b run with them instead.  Up to
+ * `jobs` programs compile at once; responses are written in request order
+ * (to stdout, or the dump file when -dump-stem/-dump-dir is given), framed
+ * as:
+ *
+ *   BEGIN <n>
+ *   <compiler output and diagnostics>
+ *   SCRIPT <len> <hex bytes>        (only on success)
+ *   END <n> ok|failed
+ */
+struct ServerJob { int n; pid_t pid; int fd; };
+
+// The flags requests are compared against are the server's command line
+// minus its platform, the server's own switches and the output switches.
+struct ServerConfig { string self, platform, flags; };
+
+ServerConfig* server_config(int argc, char* argv[]) {
+  ServerConfig* config = new ServerConfig;
+  config->self = argv[0]; config->platform = "sim";
+  for(int i=1;i<argc;i++) {
+    string a = argv[i];
+    bool has_value = (a=="--platform" || a=="--server-jobs" ||
+                      a=="--server-compile" || a=="-dump-stem" ||
+                      a=="-dump-dir");
+    if(a=="--platform" && i+1<argc) config->platform = argv[i+1];
+    if(has_value) { i++; continue; }
+    if(a=="--server" || a=="--test-mode" || a=="-D") continue;
+    config->flags += (config->flags.empty() ? "" : " ") + a;
+  }
+  return config;
+}
+
+// Compile one request in the forked child, writing to its stdout.
+static void compile_request(NeoCompiler* compiler, const ServerConfig* config,
+                            const string& request) {
+  string req_platform, req_flags, program = request;
+  size_t tab1 = request.find('\t'), tab2 = string::npos;
+  if(tab1 != string::npos) tab2 = request.find('\t',tab1+1);
+  if(tab2 != string::npos) {
+    req_platform = request.substr(0,tab1);
+    program = request.substr(tab2+1);
+    istringstream words(request.substr(tab1+1,tab2-tab1-1)); string w;
+    while(words >> w) req_flags += (req_flags.empty() ? "" : " ") + w;
+  }
+  if(req_platform.empty()) req_platform = config->platform;
+  if(req_flags.empty()) req_flags = config->flags;
+  if(req_platform != config->platform || req_flags != config->flags) {
+    // the warm compiler was set up for other options: start a cold one
+    vector<char*> argv; argv.push_back(strdup(config->self.c_str()));
+    argv.push_back(strdup("--platform"));
+    argv.push_back(strdup(req_platform.c_str()));
+    istringstream words(req_flags); string w;
+    while(words >> w) argv.push_back(strdup(w.c_str()));
+    argv.push_back(strdup("--server-compile"));
+    argv.push_back(strdup(program.c_str()));
+    argv.push_back(NULL);
+    execvp(argv[0],&argv[0]);
+    perror("exec"); exit(1);
+  }
+  compile_for_server(compiler,program);
+}
+
+// Compile a program, sending all output and the SCRIPT line to stdout.
+void compile_for_server(NeoCompiler* compiler, const string& program) {
+  cpout = cperr = &cout;
+  compiler_test_mode = false; // errors must show in the exit status
+  int len;
+  uint8_t* s = compiler->compile(program.c_str(),&len);
+  cout << "SCRIPT " << len;
+  for(int i=0;i<len;i++) {
+    char hex[4]; snprintf(hex,sizeof(hex)," %02X",s[i]); cout << hex;
+  }
+  cout << endl;
+}
+
+static void finish_job(const ServerJob& job, ostream& out) {
+  out << "BEGIN " << job.n << endl;
+  char buf[4096]; ssize_t got;
+  while((got = read(job.fd,buf,sizeof(buf))) > 0) out.write(buf,got);
+  close(job.fd);
+  int status = 0; waitpid(job.pid,&status,0);
+  bool ok = WIFEXITED(status) && WEXITSTATUS(status)==0;
+  out << "END " << job.n << (ok ? " ok" : " failed") << endl;
+}
+
+void serve(NeoCompiler* compiler, size_t jobs, const ServerConfig* config) {
+  ostream& out = *cpout;
+  std::deque<ServerJob> running;
+  string line; int n = 0;
+  while(getline(cin,line)) {
+    if(line.find_first_not_of(" \t\r") == string::npos) continue;
+    if(running.size() >= jobs) { finish_job(running.front(),out); running.pop_front(); }
+    int fds[2];
+    if(pipe(fds)) { perror("pipe"); break; }
+    out.flush(); fflush(stdout); cout.flush(); cerr.flush();
+    pid_t pid = fork();
+    if(pid < 0) { perror("fork"); close(fds[0]); close(fds[1]); break; }
+    if(pid == 0) { // child: compile and report through the pipe
+      close(fds[0]); dup2(fds[1],1); dup2(fds[1],2); close(fds[1]);
+      // detach from stdin: exit() would otherwise rewind the shared offset
+      int null = open("/dev/null",O_RDONLY); dup2(null,0); close(null);
+      compile_request(compiler,config,line);
+      exit(0);
+    }
+    close(fds[1]);
+    ServerJob job = { n++, pid, fds[0] };
+    running.push_back(job);
+  }
+  while(!running.empty()) { finish_job(running.front(),out); running.pop_front(); }
+}
+#endif
+
 /// test suite!
 extern void test_compiler_utils();
 
@@ -2252,6 +2252,90 @@ public:
   }
 };
 
+/**
+ * Neighbour-invariant code motion for fold-hood and fold-hood-plus.
+ * The lambdas handed to a fold are run once per neighbour, so an op
+ * whose inputs are only references into the enclosing round (or
+ * literals) computes the same value every time.  Such ops are moved
+ * out next to the fold and replaced by a reference to their result;
+ * repeated application lifts whole invariant subexpressions.
+ */
+class HoistHoodInvariants : public IRPropagator {
+public:
+  HoistHoodInvariants(GlobalToLocal* parent, Args* args) : IRPropagator(false,true) {
+    verbosity = args->extract_switch("--hoist-hood-invariants-verbosity") ?
+      args->pop_int() : parent->verbosity;
+  }
+  virtual void print(ostream* out=0) { *out << "HoistHoodInvariants"; }
+
+  void act(OperatorInstance* oi) {
+    if(oi->op!=Env::core_op("fold-hood") && oi->op!=Env::core_op("fold-hood-plus"))
+      return;
+    for(int i=0;i<oi->inputs.size();i++) {
+      CompoundOp* fn = private_lambda(oi->inputs[i]);
+      if(fn==NULL) continue;
+      OIset ois; fn->body->all_ois(&ois);
+      for_set(OI*,ois,j)
+        if((*j)->domain()==fn->body && invariant(*j,oi->domain()))
+          hoist(*j,oi->domain());
+    }
+  }
+
+private:
+  // The compound op behind a lambda literal, if nothing else can call it
+  CompoundOp* private_lambda(Field* f) {
+    if(f==NULL || !f->producer->op->isA("Literal")) return NULL;
+    ProtoType* v = dynamic_cast<Literal &>(*f->producer->op).value;
+    if(!v->isA("ProtoLambda")) return NULL;
+    Operator* op = dynamic_cast<ProtoLambda &>(*v).op;
+    if(op==NULL || !op->isA("CompoundOp")) return NULL;
+    // funcalls counts lambda literals too: this one must be the only use
+    if(root->funcalls[op].size()!=1) return NULL;
+    return &dynamic_cast<CompoundOp &>(*op);
+  }
+
+  // True if oi gives the same value for every neighbour and may be
+  // computed in space instead
+  bool invariant(OI* oi, AM* space) {
+    if(!oi->op->isA("Primitive") || oi->op->isA("LocalFieldOp")) return false;
+    if(oi->op==Env::core_op("reference") || oi->pointwise()!=1) return false;
+    if(oi->op->name=="rnd") return false; // a fresh draw per neighbour
+    bool any_ref = false;
+    for(int i=0;i<oi->inputs.size();i++) {
+      OI* src = oi->inputs[i]->producer;
+      if(src->op==Env::core_op("reference")) {
+        AM* d = src->inputs[0]->domain;
+        if(space!=d && !space->child_of(d)) return false;
+        any_ref = true;
+      } else if(!src->op->isA("Literal")) {
+        return false;
+      }
+    }
+    return any_ref; // all-literal ops are left to the constant folder
+  }
+
+  void hoist(OI* oi, AM* space) {
+    V2 << "Hoisting neighbour-invariant " << ce2s(oi) << endl;
+    OI* h = new OperatorInstance(oi,oi->op,space);
+    for(int i=0;i<oi->inputs.size();i++) {
+      OI* src = oi->inputs[i]->producer;
+      if(src->op==Env::core_op("reference"))
+        h->add_input(src->inputs[0]);
+      else
+        h->add_input(root->add_literal(dynamic_cast<Literal &>(*src->op).value,
+                                       space,oi));
+    }
+    h->output->range = oi->output->range;
+    for(int i=oi->inputs.size()-1;i>=0;i--) {
+      note_change(oi->inputs[i]->producer);
+      oi->remove_input(i);
+    }
+    oi->op = Env::core_op("reference");
+    oi->add_input(h->output);
+    note_change(oi); note_change(h);
+  }
+};
+
 // Map Stores to Reads
 // TODO: Put this in the Read OperatorInstance, would need to extend OI to add a field and redo the below where we just change the delay to a read
 // Need to map store and reads so we can get the right reference later in the emitter
@@ -2343,6 +2427,8 @@ GlobalToLocal::GlobalToLocal(NeoCompiler* parent, Args* args) {
   // set up rule collection
   rules.push_back(new HoodToFolder(this,args));
   rules.push_back(new RestrictToReference(this,args));
+  if(!args->extract_switch("--no-hoist-hood-invariants"))
+    rules.push_back(new HoistHoodInvariants(this,args));
   rules.push_back(new RestrictToBranch(this,args));
   rules.push_back(new DelayToStoreAndRead(this, args));
   rules.push_back(new DeadCodeEliminator(this,args));
@@ -2370,16 +2456,26 @@ GlobalToLocal::GlobalToLocal(NeoCompiler* parent, Args* args) {
 void DFGTransformer::transform(DFG* g) {
   CertifyBackpointers checker(verbosity);
   if(paranoid) checker.propagate(g); // make sure we're starting OK
+  vector<PhaseProfile*> profiles;
+  for(int j=0;j<rules.size();j++)
+    profiles.push_back(compiler_profiling ?
+                       PhaseProfile::create(compile_phase,rules[j]->to_str())
+                       : NULL);
   for(int i=0;i<max_loops;i++) {
     bool changed=false;
     for(int j=0;j<rules.size();j++) {
+      if(profiles[j]) profiles[j]->start();
       changed |= rules[j]->propagate(g); terminate_on_error();
+      if(profiles[j]) profiles[j]->stop();
       if(paranoid) checker.propagate(g); // make sure we didn't break anything
     }
     if(!changed) break;
     if(i==(max_loops-1))
       compile_warn("Transformer giving up after "+i2s(max_loops)+" loops");
   }
+  for(int j=0;j<rules.size();j++) {
+    profile_dfg(profiles[j],"_after",g); PhaseProfile::end(profiles[j]);
+  }
   g->determine_relevant();
   checker.propagate(g); // make sure we didn't break anything
 }
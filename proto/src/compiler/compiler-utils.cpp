@@ -9,6 +9,14 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "compiler-utils.h"
 
 #include <stdlib.h>
+#ifndef __WIN32__
+#include <sys/resource.h>
+#endif
+#if defined(__GLIBC__) && \
+  (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2 1
+#endif
 
 #include <list>
 #include <iostream>
@@ -158,6 +166,102 @@ terminate_on_error()
   }
 }
 
+// Phase profiling.
+bool compiler_profiling = false;
+
+static long
+peak_rss_kb()
+{
+#ifdef __WIN32__
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+# ifdef __APPLE__
+  return usage.ru_maxrss / 1024; // reported in bytes
+# else
+  return usage.ru_maxrss;
+# endif
+#endif
+}
+
+// Heap memory in use, or -1 where it cannot be measured
+static long
+heap_in_use_kb()
+{
+#if HAVE_MALLINFO2
+  struct mallinfo2 info = mallinfo2();
+  return (info.uordblks + info.hblkhd) / 1024;
+#else
+  return -1;
+#endif
+}
+
+PhaseProfile::PhaseProfile(const string &phase)
+  : phase(phase), calls(0), secs(0), started(-1), heap_kb(0),
+    started_heap_kb(0)
+{}
+
+PhaseProfile *
+PhaseProfile::create(const string &phase, const string &part)
+{
+  if (!compiler_profiling) return NULL;
+  return new PhaseProfile(part.empty() ? phase : phase + ":" + part);
+}
+
+PhaseProfile *
+PhaseProfile::begin(const string &phase, const string &part)
+{
+  PhaseProfile *p = create(phase, part);
+  if (p) p->start();
+  return p;
+}
+
+void
+PhaseProfile::end(PhaseProfile *p)
+{
+  if (!p) return;
+  p->report();
+  delete p;
+}
+
+void
+PhaseProfile::start()
+{
+  started = get_real_secs();
+  started_heap_kb = heap_in_use_kb();
+}
+
+void
+PhaseProfile::stop()
+{
+  if (started < 0) return;
+  secs += get_real_secs() - started;
+  heap_kb += heap_in_use_kb() - started_heap_kb;
+  started = -1;
+  calls++;
+}
+
+void
+PhaseProfile::count(const string &key, long value)
+{
+  counts << " " << key << "=" << value;
+}
+
+void
+PhaseProfile::report()
+{
+  stop();
+  string name = phase;
+  for (size_t i = 0; i < name.size(); i++)
+    if (name[i] == ' ') name[i] = '-';
+  *cplog << "PROFILE phase=" << name << " calls=" << calls
+         << " ms=" << flo2str(secs * 1000, 3);
+  if (heap_in_use_kb() >= 0) *cplog << " heap_kb=" << heap_kb;
+  *cplog << " maxrss_kb=" << peak_rss_kb() << counts.str() << endl;
+}
+
 uint32_t CompilationElement::max_id = 0;
 
 // STANDALONE TESTER: To run this test, modify the compiler to call it.
@@ -71,6 +71,47 @@ void compile_warn(CompilationElement *where, const std::string &msg);
 /// Clean-up & kill application.
 void terminate_on_error();
 
+/********** PHASE PROFILING **********/
+
+// When true, phases report time, memory and sizes to cplog.
+extern bool compiler_profiling;
+
+/**
+ * Measures one compiler phase for -profile-compiler.  Time and the growth
+ * of heap memory in use are accumulated over start()/stop() intervals; the
+ * compiler hardly frees, so heap growth tracks what the phase allocated.
+ * report() prints one machine-readable record to cplog:
+ *   PROFILE phase=<name> calls=<n> ms=<time> heap_kb=<growth>
+ *           maxrss_kb=<process high-water mark> [<key>=<value> ...]
+ * heap_kb is only measured with glibc; elsewhere it is absent.  Profiles
+ * are only ever made when compiler_profiling is set: create() and begin()
+ * return NULL otherwise, and end() ignores NULL.
+ */
+class PhaseProfile {
+ public:
+  /// A profile for phase (with ":"+part appended), or NULL if not profiling
+  static PhaseProfile *create(const std::string &phase,
+                              const std::string &part = "");
+  /// As create(), and start timing at once
+  static PhaseProfile *begin(const std::string &phase,
+                             const std::string &part = "");
+  /// Report and delete a profile; does nothing for NULL
+  static void end(PhaseProfile *p);
+
+  void start();
+  void stop();
+  void count(const std::string &key, long value);
+  void report();
+
+ private:
+  PhaseProfile(const std::string &phase);
+  std::string phase;
+  std::ostringstream counts;
+  int calls;
+  double secs, started;
+  long heap_kb, started_heap_kb;
+};
+
 // Standard levels for verbosity:
 #define V1 if (verbosity >= 1) *cpout // Major stages
 #define V2 if (verbosity >= 2) *cpout << " "  // Actions
@@ -39,18 +39,43 @@ using namespace std;
 // Error behavior: in any given stage, do all the independent processing
 // that's possible, flag if there's an error, and then quit
 
+// Record the size of the DFG in a profile, with keys suffixed by `when`
+void profile_dfg(PhaseProfile *p, const string &when, DFG *g) {
+  if(!p) return;
+  p->count("nodes"+when, g->nodes.size());
+  p->count("fields"+when, g->edges.size());
+  p->count("spaces"+when, g->spaces.size());
+}
+
+// Profile a compilation phase that transforms the DFG
+static PhaseProfile *begin_dfg_profile(DFG *g) {
+  PhaseProfile *p = PhaseProfile::create(compile_phase);
+  profile_dfg(p, "_before", g);
+  if(p) p->start();
+  return p;
+}
+static void end_dfg_profile(PhaseProfile *p, DFG *g) {
+  if(p) p->stop();
+  profile_dfg(p, "_after", g);
+  PhaseProfile::end(p);
+}
+
 // len is filled in w. output length... eventually
 uint8_t* NeoCompiler::compile(const char *str, int* len) {
   last_script=str;
   V1 << "Parsing expression...\n";
   compile_phase = "parsing"; // PHASE: text-> sexpr
+  PhaseProfile *parse_profile = PhaseProfile::begin(compile_phase);
   SExpr* sexpr = read_sexpr("command-line",str);
   compiler_error|=!sexpr; terminate_on_error();
+  PhaseProfile::end(parse_profile);
   V1 << "Interpreting parsed expression into DFG...\n";
   compile_phase = "interpretation"; // PHASE: sexpr -> IR
+  PhaseProfile *interpret_profile = begin_dfg_profile(interpreter->dfg);
   interpreter->interpret(sexpr); // terminates on error internally
   if(interpreter->dfg->output==NULL)
     { compile_error("Program has no content."); terminate_on_error(); }
+  end_dfg_profile(interpret_profile, interpreter->dfg);
   if(is_dump_interpreted) interpreter->dfg->print(cpout);
   if(is_dump_dotfiles) {
     ofstream dotstream((dotstem+".interpreted.dot").c_str());
@@ -61,7 +86,9 @@ uint8_t* NeoCompiler::compile(const char *str, int* len) {
   
   V1 << "Analyzing and optimizing DFG...\n";
   compile_phase = "analysis"; // PHASE: IR manipulation
+  PhaseProfile *analysis_profile = begin_dfg_profile(interpreter->dfg);
   analyzer->transform(interpreter->dfg); // terminates on error internally
+  end_dfg_profile(analysis_profile, interpreter->dfg);
   if(is_dump_analyzed) interpreter->dfg->print(cpout);
   if(is_dump_dotfiles) {
     ofstream dotstream((dotstem+".analyzed.dot").c_str());
@@ -71,12 +98,16 @@ uint8_t* NeoCompiler::compile(const char *str, int* len) {
     { *cperr << "Stopping before localization" << endl; exit(0); }
   
   compile_phase = "legality check"; // PHASE: legality check
+  PhaseProfile *legality_profile = PhaseProfile::begin(compile_phase);
   IRPropagator *p = new CheckTypeConcreteness();
   p->propagate(interpreter->dfg);
+  PhaseProfile::end(legality_profile);
   
   V1 << "Global-to-local transformation of DFG...\n";
   compile_phase = "localization"; // PHASE: Global-to-local transformation
+  PhaseProfile *localization_profile = begin_dfg_profile(interpreter->dfg);
   localizer->transform(interpreter->dfg); // terminates on error internally
+  end_dfg_profile(localization_profile, interpreter->dfg);
   if(is_dump_raw_localized) interpreter->dfg->print(cpout);
   if(is_dump_dotfiles) {
     ofstream dotstream((dotstem+".rawlocalized.dot").c_str());
@@ -84,7 +115,9 @@ uint8_t* NeoCompiler::compile(const char *str, int* len) {
   }
   V1 << "Analyzing and optimizing localized DFG\n";
   compile_phase = "local analysis"; // PHASE: IR manipulation
+  PhaseProfile *local_analysis_profile = begin_dfg_profile(interpreter->dfg);
   analyzer->transform(interpreter->dfg); // terminates on error internally
+  end_dfg_profile(local_analysis_profile, interpreter->dfg);
   if(is_dump_localized) interpreter->dfg->print(cpout);
   if(is_dump_dotfiles) {
     ofstream dotstream((dotstem+".localized.dot").c_str());
@@ -95,7 +128,11 @@ uint8_t* NeoCompiler::compile(const char *str, int* len) {
   
   V1 << "Emitting DFG to executable form...\n";
   compile_phase = "emission"; // PHASE: code emission
-  return emitter->emit_from(interpreter->dfg, len);
+  PhaseProfile *emission_profile = PhaseProfile::begin(compile_phase);
+  uint8_t* script = emitter->emit_from(interpreter->dfg, len);
+  if(emission_profile) emission_profile->count("script_bytes", *len);
+  PhaseProfile::end(emission_profile);
+  return script;
 }
 
 /*****************************************************************************
@@ -129,7 +166,10 @@ NeoCompiler::NeoCompiler(Args* args) : Compiler(args) {
   while(args->extract_switch("-path",false)) // can extract multiple times
     proto_path.add_to_path(args->pop_next());
   
+  compiler_profiling = args->extract_switch("-profile-compiler");
+  PhaseProfile *init_profile = PhaseProfile::begin(compile_phase);
   interpreter = new ProtoInterpreter(this,args);
+  PhaseProfile::end(init_profile);
   analyzer = new ProtoAnalyzer(this,args);
   localizer = new GlobalToLocal(this,args);
 
@@ -176,7 +216,7 @@ NeoCompiler::init_standalone(Args *args)
     cpout = new ofstream(buf);
   }
   if (compiler_test_mode)
-    cperr = cpout;
+    cperr = cplog = cpout;
 
   // Default is to emit for ProtoKernel.
   if (args->extract_switch("-EM")) {
@@ -150,7 +150,7 @@ class Block;
 
 class ProtoKernelEmitter : public CodeEmitter { public: reflection_sub(ProtoKernelEmitter, CodeEmitter);
  public:
-  bool is_dump_hex, paranoid;
+  bool is_dump_hex, paranoid, typed_ops;
   static bool op_debug;
   int max_loops, verbosity, print_compact;
   NeoCompiler *parent;
@@ -173,6 +173,8 @@ class ProtoKernelEmitter : public CodeEmitter { public: reflection_sub(ProtoKern
  private:
   std::vector<InstructionPropagator *> rules;
   std::vector<IRPropagator *> preemitter_rules;
+  /// Optional optimization pass, run once everything is resolved.
+  InstructionPropagator *peephole;
 
   /// Global & env storage.
   std::map<Field *,CompilationElement *, CompilationElement_cmp> memory;
@@ -186,18 +188,26 @@ class ProtoKernelEmitter : public CodeEmitter { public: reflection_sub(ProtoKern
   /// List of folding ops, which are also scalar/vector pairs.
   std::map<std::string, std::pair<int, int> > fold_ops;
 
+  /// Number-only versions of ops, used when all operands are scalars.
+  std::map<std::string, int> num_ops;
+
+  /// Fixed-width vector versions of ops: width -> opcode.
+  std::map<std::string, std::map<int, int> > fixed_vec_ops;
+
   /// List of Feedback ops, dchange, delay
   std::map<std::string, std::pair<int, int> > feedback_ops;
 
   Instruction *start, *end;
 
   void load_ops(const std::string &name);
+  void resolve_instructions(std::vector<PhaseProfile *> &profiles);
   void read_extension_ops(std::istream *stream);
   void load_extension_ops(const std::string &name);
   void process_extension_ops(SExpr *sexpr);
   void process_extension_op(SExpr *sexpr);
   Instruction *tree2instructions(Field *f);
   Instruction *primitive_to_instruction(OperatorInstance *oi);
+  Instruction *typed_primitive_instruction(OperatorInstance *oi);
   Instruction *standard_primitive_instruction(OperatorInstance *oi);
   Instruction *vector_primitive_instruction(OperatorInstance *oi);
   Instruction *fold_primitive_instruction(OperatorInstance *oi);
@@ -271,6 +281,9 @@ class NeoCompiler : public Compiler {
   void setDefops(const std::string &defops);
 };
 
+/// Record DFG node, field & space counts in a profile (keys suffixed by when)
+void profile_dfg(PhaseProfile *p, const std::string &when, DFG *g);
+
 /// list of internal tests:
 void type_system_tests();
 
@@ -1388,6 +1388,96 @@ public:
 };
 
 
+// Rewrites resolved instruction sequences into shorter equivalents: a
+// let whose only use immediately follows it is dropped entirely, and the
+// most frequent environment pairs are fused into superinstructions.
+class Peephole : public InstructionPropagator {
+public:
+  Peephole(ProtoKernelEmitter* parent,Args* args) {
+    verbosity = args->extract_switch("--peephole-verbosity") ?
+      args->pop_int() : parent->verbosity;
+  }
+  void print(ostream* out=0) { *out<<"Peephole"; }
+
+  void preprop() { // branches must never land inside a rewritten sequence
+    targets.clear(); collect_targets(root);
+  }
+
+  void act(Instruction* i) {
+    if(i->marked("~Peephole~Deleted")) return;
+    if(i->isA("iLET") && i->op==LET_1_OP) {
+      iLET* l = &dynamic_cast<iLET &>(*i);
+      if(!l->next || l->next->op!=REF_0_OP || !l->next->isA("Reference")
+         || targets.count(l)) return;
+      Reference* r = &dynamic_cast<Reference &>(*l->next);
+      if(r->store!=l || r->marked("~Read-Reference")) return;
+      if(drop_let(l,r)) return;
+      V2 << "Fusing " << ce2s(l) << " and " << ce2s(r) << endl;
+      if(targets.count(r)) retarget(r,l);
+      unlink(r);
+      l->op = LET_1_REF_0_OP; l->stack_delta = 0;
+      note_change(l);
+    } else if(i->op==REF_0_OP && i->isA("Reference")) {
+      if(!i->next || i->next->op!=POP_LET_1_OP || targets.count(i)) return;
+      V2 << "Fusing " << ce2s(i) << " and " << ce2s(i->next) << endl;
+      Instruction* pop = i->next;
+      unlink(i);
+      pop->op = REF_0_POP_LET_1_OP; pop->stack_delta = 1;
+      note_change(pop);
+    }
+  }
+
+private:
+  CEmap(Instruction*,CEset(Branch*)) targets;
+
+  void collect_targets(Instruction* chain) {
+    for(; chain; chain=chain->next) {
+      if(chain->isA("Block"))
+        collect_targets(dynamic_cast<Block &>(*chain).contents);
+      if(chain->isA("Branch")) {
+        Branch* b = &dynamic_cast<Branch &>(*chain);
+        targets[b->after_this].insert(b);
+      }
+    }
+  }
+
+  void retarget(Instruction* from, Instruction* to) {
+    for_set(Branch*,targets[from],b) { (*b)->after_this = to; }
+    targets[to].insert(targets[from].begin(),targets[from].end());
+    targets.erase(from);
+  }
+
+  // LET_1, REF_0, POP_LET_1 leaves the stack exactly as it found it
+  bool drop_let(iLET* l, Reference* r) {
+    Instruction* pop = r->next;
+    if(!pop || pop!=l->pop || pop->op!=POP_LET_1_OP || targets.count(r)
+       || targets.count(pop) || l->marked("~Fold-Reference")) return false;
+    if(l->usages.size()!=1 || l->dependents.size()!=1) return false;
+    if(l->container && l->container->contents==l && !pop->next) return false;
+    V2 << "Dropping redundant " << ce2s(l) << " and " << ce2s(pop) << endl;
+    Instruction* after = l->prev;
+    unlink(l); unlink(r); unlink(pop);
+    if(after) note_change(after);
+    return true;
+  }
+
+  void unlink(Instruction* i) {
+    if(i->isA("Reference")) {
+      Reference* r = &dynamic_cast<Reference &>(*i);
+      r->store->dependents.erase(r);
+      if(r->store->isA("iLET")) dynamic_cast<iLET &>(*r->store).usages.erase(r);
+    }
+    if(i->container) {
+      if(i->container->contents==i) i->container->contents = i->next;
+      i->container->dependents.erase(i);
+    }
+    note_change(i);
+    chain_delete(i,i);
+    i->mark("~Peephole~Deleted");
+  }
+};
+
+
 // Ensure that all stores in references are non-null
 class ResolveForwardReferences : public InstructionPropagator {
 public:
@@ -1719,6 +1809,11 @@ ProtoKernelEmitter::primitive_to_instruction(OperatorInstance *oi)
 {
   Primitive *primitive = &dynamic_cast<Primitive &>(*oi->op);
 
+  if (typed_ops) {
+    Instruction *typed = typed_primitive_instruction(oi);
+    if (typed) return typed;
+  }
+
   if (primitive2op.count(primitive->name))
     return standard_primitive_instruction(oi);
   else if (sv_ops.count(primitive->name))
@@ -1774,6 +1869,9 @@ ProtoKernelEmitter::vector_primitive_instruction(OperatorInstance *oi)
         tuple_p = true;
         break;
       }
+  // VMUX takes the store for its output as an operand, which a mux choosing
+  // between a number and a tuple does not have; MUX copies either
+  if (p->name == "mux") tuple_p = output_tuple_p;
   OPCODE opcode = (tuple_p ? sv_ops[p->name].second : sv_ops[p->name].first);
 
   // Now add ops: possible multiple if n-ary.
@@ -1790,6 +1888,51 @@ ProtoKernelEmitter::vector_primitive_instruction(OperatorInstance *oi)
 
 // FIXME: Reduce code duplicated in vector_primitive_instruction.
 
+// Width of a bounded vector type, or 0 if it is anything else.
+static int
+fixed_vector_width(ProtoType *type)
+{
+  if (!type->isA("ProtoVector")) return 0;
+  ProtoTuple *tuple = &dynamic_cast<ProtoTuple &>(*type);
+  return tuple->bounded ? tuple->types.size() : 0;
+}
+
+// When the analyzer has proven that every operand is a scalar, or that
+// every operand is a vector of the same small width, use an op that
+// skips the VM's run-time type dispatch.  Returns 0 to fall back on the
+// generic ops.
+Instruction *
+ProtoKernelEmitter::typed_primitive_instruction(OperatorInstance *oi)
+{
+  Primitive *p = &dynamic_cast<Primitive &>(*oi->op);
+  if (oi->inputs.size() < 2) return 0;
+
+  OPCODE opcode;
+  bool all_scalar = oi->output->range->isA("ProtoScalar");
+  for (size_t i = 0; i < oi->inputs.size(); i++)
+    all_scalar &= oi->inputs[i]->range->isA("ProtoScalar");
+  int width = fixed_vector_width(oi->output->range);
+  for (size_t i = 0; i < oi->inputs.size(); i++)
+    if (fixed_vector_width(oi->inputs[i]->range) != width) width = 0;
+
+  if (all_scalar && num_ops.count(p->name))
+    opcode = num_ops[p->name];
+  else if (width && fixed_vec_ops.count(p->name)
+           && fixed_vec_ops[p->name].count(width))
+    opcode = fixed_vec_ops[p->name][width];
+  else
+    return 0;
+  V4 << "Typed op for " << ce2s(oi) << ": " << opnames[opcode] << endl;
+
+  // n-ary ops chain copies; n-ary division multiplies the divisors first.
+  size_t n_copies = (p->signature->rest_input ? (oi->inputs.size() - 1) : 1);
+  Instruction *chain = 0;
+  for (size_t i = 0; i < n_copies; i++)
+    chain_i(&chain, new Instruction((p->name == "/" && i < n_copies - 1)
+                                    ? NUM_MUL_OP : opcode));
+  return chain_start(chain);
+}
+
 // Mark operator instances as they are emitted, to ensure they are
 // not emitted multiple times
 void ensure_one_emission(OI* oi) {
@@ -2203,6 +2346,23 @@ ProtoKernelEmitter::load_ops(const string &name)
 
   fold_ops["fold-hood"] = make_pair(FOLD_HOOD_OP, VFOLD_HOOD_OP);
   fold_ops["fold-hood-plus"] = make_pair(FOLD_HOOD_PLUS_OP, VFOLD_HOOD_PLUS_OP);
+
+  num_ops["+"] = NUM_ADD_OP;
+  num_ops["-"] = NUM_SUB_OP;
+  num_ops["*"] = NUM_MUL_OP;
+  num_ops["/"] = NUM_DIV_OP;
+  num_ops["<"] = NUM_LT_OP;
+  num_ops["<="] = NUM_LTE_OP;
+  num_ops[">"] = NUM_GT_OP;
+  num_ops[">="] = NUM_GTE_OP;
+  num_ops["="] = NUM_EQ_OP;
+  num_ops["max"] = NUM_MAX_OP;
+  num_ops["min"] = NUM_MIN_OP;
+
+  fixed_vec_ops["+"][2] = VEC_ADD_2_OP;
+  fixed_vec_ops["+"][3] = VEC_ADD_3_OP;
+  fixed_vec_ops["-"][2] = VEC_SUB_2_OP;
+  fixed_vec_ops["-"][3] = VEC_SUB_3_OP;
 }
 
 // Load a .proto file named `name', containing not Proto code but
@@ -2388,6 +2548,7 @@ ProtoKernelEmitter::ProtoKernelEmitter(NeoCompiler *parent, Args *args)
   max_loops=args->extract_switch("--emitter-max-loops") ? args->pop_int() : 10;
   paranoid = args->extract_switch("--emitter-paranoid") | parent->paranoid;
   op_debug = args->extract_switch("--emitter-op-debug");
+  typed_ops = args->extract_switch("--emit-typed-ops");
   // Load operation definitions.
   load_ops("core.ops");
   terminate_on_error();
@@ -2401,6 +2562,8 @@ ProtoKernelEmitter::ProtoKernelEmitter(NeoCompiler *parent, Args *args)
   rules.push_back(new ResolveLocations(this, args));
   rules.push_back(new StackEnvSizer(this, args));
   rules.push_back(new ResolveState(this, args));
+  peephole = args->extract_switch("--emit-peephole") ? new Peephole(this, args)
+    : NULL;
   // Program starts empty.
   start = end = NULL;
 }
@@ -2608,6 +2771,21 @@ Instruction* ProtoKernelEmitter::dfg2instructions(AM* root) {
   return fnstart;
 }
 
+void
+ProtoKernelEmitter::resolve_instructions(vector<PhaseProfile*> &profiles) {
+  for(int i=0;i<max_loops;i++) {
+    bool changed=false;
+    for(int j=0;j<rules.size();j++) {
+      if(profiles[j]) profiles[j]->start();
+      changed |= rules[j]->propagate(start); terminate_on_error();
+      if(profiles[j]) profiles[j]->stop();
+    }
+    if(!changed) break;
+    if(i==(max_loops-1))
+      compile_warn("Emitter analyzer giving up after "+i2s(max_loops)+" loops");
+  }
+}
+
 string hexbyte(uint8_t v) {
   string hex = "0123456789ABCDEF";
   string out = "xx"; out[0]=hex[v>>4]; out[1]=hex[v & 0xf]; return out;
@@ -2620,7 +2798,12 @@ uint8_t* ProtoKernelEmitter::emit_from(DFG* g, int* len) {
   for(int i=0; i<preemitter_rules.size(); i++) {
      IRPropagator *propagator
        = &dynamic_cast<IRPropagator &>(*preemitter_rules[i]);
+     PhaseProfile *profile
+       = compiler_profiling ? PhaseProfile::begin(compile_phase,
+                                                  propagator->to_str()) : NULL;
      propagator->propagate(g);
+     if(profile) profile->stop();
+     profile_dfg(profile,"_after",g); PhaseProfile::end(profile);
   }
 
   if(parent->is_dump_dotfiles) {
@@ -2629,6 +2812,8 @@ uint8_t* ProtoKernelEmitter::emit_from(DFG* g, int* len) {
   }
 
   V1<<"Linearizing DFG to instructions...\n";
+  PhaseProfile *linearize_profile
+    = PhaseProfile::begin(compile_phase,"linearization");
   start = end = new iDEF_VM(); // start of every script
 
   // Output all functions in arbitrary order.  Forward refs are resolved later
@@ -2670,18 +2855,25 @@ uint8_t* ProtoKernelEmitter::emit_from(DFG* g, int* len) {
     }
   }
   if(badnodes) ierror("Not all operator instances were emitted.");
+  PhaseProfile::end(linearize_profile);
 
   // Fill in all of the blanks
   V1<<"Resolving unknowns in instruction sequence...\n";
-  for(int i=0;i<max_loops;i++) {
-    bool changed=false;
-    for(int j=0;j<rules.size();j++) {
-      changed |= rules[j]->propagate(start); terminate_on_error();
-    }
-    if(!changed) break;
-    if(i==(max_loops-1))
-      compile_warn("Emitter analyzer giving up after "+i2s(max_loops)+" loops");
-  }
+  vector<PhaseProfile*> profiles;
+  for(int j=0;j<rules.size();j++)
+    profiles.push_back(compiler_profiling ?
+                       PhaseProfile::create(compile_phase,rules[j]->to_str())
+                       : NULL);
+  resolve_instructions(profiles);
+  if(peephole) {
+    V1<<"Optimizing instruction sequence...\n";
+    PhaseProfile *peephole_profile = compiler_profiling ?
+      PhaseProfile::begin(compile_phase,peephole->to_str()) : NULL;
+    bool changed = peephole->propagate(start);
+    PhaseProfile::end(peephole_profile);
+    if(changed) resolve_instructions(profiles);
+  }
+  for(int j=0;j<rules.size();j++) PhaseProfile::end(profiles[j]);
   CheckResolution rchecker(this); rchecker.propagate(start);
   
   // finally, output
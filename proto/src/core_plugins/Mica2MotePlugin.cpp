@@ -64,7 +64,7 @@ void MoteIO::conductive_op(Machine* machine) {
 }
 
 void MoteIO::button_op(Machine* machine) {
-  machine->stack.push(read_button((int) machine->stack.popNumber()));
+  machine->stack.push(read_button((int) Number_toDouble(machine->stack.popNumber())));
 }
 
 void MoteIO::slider_op(Machine* machine) {
@@ -72,8 +72,8 @@ void MoteIO::slider_op(Machine* machine) {
   Number min  = machine->stack.popNumber();
   Number incr = machine->stack.popNumber();
   Number init = machine->stack.popNumber();
-  int     ikey = (int)machine->stack.popNumber();
-  int     dkey = (int)machine->stack.popNumber();
+  int     ikey = (int)Number_toDouble(machine->stack.popNumber());
+  int     dkey = (int)Number_toDouble(machine->stack.popNumber());
   machine->stack.push(read_slider(dkey, ikey, init, incr, min, max));
 }
 
@@ -9,12 +9,20 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "RadioModelsPlugin.h"
 #include "multiradio.h"
 #include "wormhole-radio.h"
+#include "hetero-radio.h"
+#include "pathloss-radio.h"
+#include "csma-radio.h"
+#include "radio-meter.h"
 
 void* RadioModelsPlugin::get_sim_plugin(string type,string name,Args* args, 
                                         SpatialComputer* cpu, int n) {
   if(type == LAYER_PLUGIN) {
     if(name == WORM_HOLES_NAME) { return new WormHoleRadio(args, cpu, n); }
     if(name == MULTI_RADIO_NAME) { return new MultiRadio(args, cpu, n); }
+    if(name == HETERO_RADIO_NAME) { return new HeteroRadio(args, cpu, n); }
+    if(name == PATHLOSS_RADIO_NAME) { return new PathLossRadio(args, cpu, n); }
+    if(name == CSMA_RADIO_NAME) { return new CsmaRadio(args, cpu, n); }
+    if(name == RADIO_METER_NAME) { return new RadioMeter(args, cpu); }
   }
   return NULL;
 }
@@ -22,7 +30,11 @@ void* RadioModelsPlugin::get_sim_plugin(string type,string name,Args* args,
 string RadioModelsPlugin::inventory() {
   return "# More complex radio models\n" +
     registry_entry(LAYER_PLUGIN,WORM_HOLES_NAME,DLL_NAME) +
-    registry_entry(LAYER_PLUGIN,MULTI_RADIO_NAME,DLL_NAME);
+    registry_entry(LAYER_PLUGIN,MULTI_RADIO_NAME,DLL_NAME) +
+    registry_entry(LAYER_PLUGIN,HETERO_RADIO_NAME,DLL_NAME) +
+    registry_entry(LAYER_PLUGIN,PATHLOSS_RADIO_NAME,DLL_NAME) +
+    registry_entry(LAYER_PLUGIN,CSMA_RADIO_NAME,DLL_NAME) +
+    registry_entry(LAYER_PLUGIN,RADIO_METER_NAME,DLL_NAME);
 }
 
 extern "C" {
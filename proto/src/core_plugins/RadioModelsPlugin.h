@@ -13,6 +13,10 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 
 #define WORM_HOLES_NAME "wormholes"
 #define MULTI_RADIO_NAME "multiradio"
+#define HETERO_RADIO_NAME "hetero-radio"
+#define PATHLOSS_RADIO_NAME "pathloss-radio"
+#define CSMA_RADIO_NAME "csma-radio"
+#define RADIO_METER_NAME "radio-meter"
 #define DLL_NAME "libradiomodels"
 
 // Plugin class
@@ -80,7 +80,7 @@ extern Machine * machine;
 void SimpleLifeCycleDevice::update() {
   if(clone_cmd) {
     if(clone_time<0) { 
-      clone_time = (machine->startTime() + parent->clone_delay); 
+      clone_time = Number_toDouble(machine->startTime() + parent->clone_delay); 
     }
     if(machine->startTime() >= clone_time) {
       clone_cmd=false; // reset clone_cmd
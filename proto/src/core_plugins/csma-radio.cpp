@@ -0,0 +1,229 @@
+/* Unit disc radio with a CSMA medium access model
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include "csma-radio.h"
+#include "visualizer.h"
+
+/*****************************************************************************
+ *  CSMA RADIO                                                               *
+ *****************************************************************************/
+CsmaRadio::CsmaRadio(Args* args, SpatialComputer* p, int n)
+  : RadioSim(args, p) {
+  ensure_colors_registered("CsmaRadio");
+  range = (args->extract_switch("-r"))?args->pop_number():15.0;
+  r_sqr = range*range;
+  // defaults are roughly those of an 802.15.4 radio
+  bitrate = (args->extract_switch("-mac-bitrate"))?args->pop_number():250000;
+  header_bytes =
+    (args->extract_switch("-mac-header"))?(int)args->pop_number():17;
+  slot = (args->extract_switch("-mac-slot"))?args->pop_number():0.00032;
+  cw_min = (args->extract_switch("-mac-cw-min"))?(int)args->pop_number():8;
+  cw_max = (args->extract_switch("-mac-cw-max"))?(int)args->pop_number():32;
+  max_retries =
+    (args->extract_switch("-mac-retries"))?(int)args->pop_number():4;
+  // display options
+  is_show_radio = args->extract_switch("-show-radio");
+  args->undefault(&can_dump,"-Dradio","-NDradio");
+  // register hardware patches
+  p->hardware.patch(this,READ_RADIO_RANGE_FN);
+  p->hardware.patch(this,RADIO_SEND_EXPORT_FN);
+  p->hardware.patch(this,RADIO_SEND_SCRIPT_PKT_FN);
+  p->hardware.patch(this,RADIO_SEND_DIGEST_FN);
+
+  cells = new CellIndex(parent->volume,range);
+}
+
+CsmaRadio::~CsmaRadio() {
+  delete cells; // populations assumed empty
+}
+
+Color *CsmaRadio::RADIO_RANGE_RING;
+void CsmaRadio::register_colors() {
+#ifdef WANT_GLUT
+  RADIO_RANGE_RING =
+    palette->register_color("RADIO_RANGE_RING", 0.25, 0.25, 0.25, 0.8);
+#endif
+}
+
+bool CsmaRadio::handle_key(KeyEvent* key) {
+  if(key->normal && !key->ctrl) {
+    switch(key->key) {
+    case 'r': is_show_radio = !is_show_radio; return true;
+    }
+  }
+  return RadioSim::handle_key(key);
+}
+
+void CsmaRadio::dump_header(FILE* out) {
+  if(can_dump)
+    fprintf(out," \"SENT\" \"BACKOFFS\" \"COLLISIONS\" \"DROPPED\"");
+}
+
+void CsmaRadio::add_device(Device* d) {
+  CsmaDevice* cd = new CsmaDevice(this,d);
+  d->layers[id] = cd;
+  cd->cell = cells->cell_at(d->body->position());
+  cd->cell_loc = cd->cell->add(d);
+}
+
+void CsmaRadio::device_moved(Device* d) {
+  CsmaDevice* cd = (CsmaDevice*)d->layers[id];
+  Population* c = cells->cell_at(d->body->position());
+  if(c==cd->cell) return;
+  cells->remove(cd->cell,cd->cell_loc);
+  cd->cell = c; cd->cell_loc = c->add(d);
+}
+
+// squared distance between two points
+static flo dist3sqr(const flo* a, const flo* b) {
+  flo dx = a[0]-b[0], dy = a[1]-b[1], dz = a[2]-b[2];
+  return dx*dx + dy*dy + dz*dz;
+}
+
+// every device other than the one at p that is within range of it
+void CsmaRadio::in_range(const flo* p, vector<Device*>* out) {
+  vector<Population*> near;
+  cells->cells_near(p,range,&near);
+  for(int c=0;c<near.size();c++) {
+    for(int i=0;i<near[c]->max_id();i++) {
+      Device* d = (Device*)near[c]->get(i);
+      if(d && d!=device && dist3sqr(p,d->body->position()) < r_sqr)
+        out->push_back(d);
+    }
+  }
+}
+
+/*****************************************************************************
+ *  HARDWARE EMULATION                                                       *
+ *****************************************************************************/
+Number CsmaRadio::read_radio_range () { return range; }
+
+int CsmaRadio::radio_send_export (uint8_t version, Array<Data> const & data) {
+  if(!try_tx())  // transmission failure
+    return 0;
+
+  SECONDS now = parent->sim_time;
+  CsmaDevice* cd = (CsmaDevice*)device->layers[id];
+  // back off, then check the channel; widen the window while it is busy
+  SECONDS start = now;
+  int cw = cw_min, waited = 0;
+  for(int tries=0;;tries++) {
+    int slots = min(cw-1,(int)urnd(0,cw));
+    start += slots*slot; waited += slots;
+    if(cd->busy_until <= start) break;
+    cd->backoffs++;
+    if(tries >= max_retries) { cd->dropped++; cd->last_backoff = waited; return 0; }
+    cw = min(2*cw,cw_max);
+  }
+  cd->last_backoff = waited;
+  vector<bool> const * changed = delta_of(device);
+  SECONDS end = start + (header_bytes+sent_size(data,changed))*8/bitrate;
+  cd->busy_until = max(cd->busy_until,end);
+  cd->tx_until = end;
+  cd->sent++;
+
+  int src_id = device->uid;
+  const flo* me = device->body->position();
+  vector<Device*> nbrs;
+  in_range(me,&nbrs);
+  for(int i=0;i<nbrs.size();i++) {
+    CsmaDevice* rd = (CsmaDevice*)nbrs[i]->layers[id];
+    rd->busy_until = max(rd->busy_until,end); // carrier sense
+    if(rd->tx_until > start) continue; // half duplex: it is talking
+    if(rd->rx_until > start) { // overlaps a packet already arriving
+      if(rd->receiving) rd->receiving->collided = true;
+      rd->collisions++;
+      rd->rx_until = max(rd->rx_until,end);
+      continue;
+    }
+    Delivery* dv = new Delivery();
+    dv->src_uid = src_id; dv->seq = version; dv->imports = data;
+    dv->is_delta = (changed!=NULL); if(changed) dv->changed = *changed;
+    const flo* them = nbrs[i]->body->position();
+    for(int j=0;j<3;j++) dv->dp[j] = me[j]-them[j];
+    dv->sent = now; dv->arrival = end; dv->collided = false;
+    rd->receiving = dv; rd->rx_until = end;
+    rd->pending.push(dv);
+  }
+  return 1;
+}
+
+// scripts are not transmitted in the simulator (see UnitDiscRadio)
+int CsmaRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
+                                      uint8_t pkt_num, uint8_t *script) {
+  return 0;
+}
+
+int CsmaRadio::radio_send_digest (uint8_t version, uint16_t script_len,
+                                  uint8_t *digest) {
+  return 0;
+}
+
+/*****************************************************************************
+ *  PER-DEVICE STATE                                                         *
+ *****************************************************************************/
+CsmaDevice::CsmaDevice(CsmaRadio* parent, Device* container)
+  : DeviceLayer(container) {
+  this->parent = parent;
+  busy_until = tx_until = rx_until = -HUGE_VAL; receiving = NULL;
+  last_backoff = sent = backoffs = collisions = dropped = 0;
+}
+
+CsmaDevice::~CsmaDevice() {
+  while(!pending.empty()) { delete pending.top(); pending.pop(); }
+  Device* removed = (Device*)parent->cells->remove(cell,cell_loc);
+  if(removed!=container) { debug("Bad back cell reference!\n"); }
+}
+
+void CsmaDevice::preupdate() {
+  SECONDS now = parent->parent->sim_time;
+  while(!pending.empty() && pending.top()->arrival <= now) {
+    Delivery* dv = pending.top(); pending.pop();
+    if(dv==receiving) receiving = NULL;
+    if(!dv->collided && parent->try_rx()) { // non-failing receive
+      Neighbour* nbr =
+        parent->receive_export(container->vm,dv->src_uid,dv->seq,
+                               dv->imports,dv->is_delta ? &dv->changed : NULL);
+      if(nbr) { // else a delta without a fresh base
+        nbr->x = dv->dp[0];
+        nbr->y = dv->dp[1];
+        nbr->z = dv->dp[2];
+        nbr->lag = dv->arrival - dv->sent;
+      }
+    }
+    delete dv;
+  }
+}
+
+void CsmaDevice::dump_state(FILE* fp, int verbosity) {
+  if(verbosity==0) {
+    fprintf(fp," %d %d %d %d",sent,backoffs,collisions,dropped);
+  } else {
+    fprintf(fp,"Sent = %d, Backoffs = %d, Collisions = %d, Dropped = %d\n",
+            sent,backoffs,collisions,dropped);
+  }
+}
+
+void CsmaDevice::visualize() {
+#ifdef WANT_GLUT
+  if (parent->is_show_backoff) {
+    glPushMatrix();
+    container->text_scale(); // prepare to draw text
+    char buf[20];
+    palette->use_color(RadioSim::RADIO_BACKOFF);
+    sprintf(buf, "%d", last_backoff);
+    draw_text(1, 1, buf);
+    glPopMatrix();
+  }
+  if(parent->is_show_radio) { // draw radio range
+    palette->use_color(CsmaRadio::RADIO_RANGE_RING);
+    draw_circle(parent->range);
+  }
+#endif // WANT_GLUT
+}
@@ -0,0 +1,106 @@
+/* Unit disc radio with a CSMA medium access model
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __CSMARADIO__
+#define __CSMARADIO__
+
+#include "proto_plugin.h"
+#include "spatialcomputer.h"
+#include "radio.h"
+#include "spatialindex.h"
+#include <queue>
+using namespace std;
+
+// A packet on its way to one receiver
+struct Delivery {
+  int src_uid;
+  uint8_t seq;        // the export's sequence number
+  Array<Data> imports;
+  bool is_delta;      // -delta-exports: only the changed slots count
+  vector<bool> changed;
+  METERS dp[3];       // position of sender relative to receiver
+  SECONDS sent, arrival;
+  bool collided;
+};
+
+// orders a receiver's queue so that the earliest arrival comes out first
+struct LaterArrival {
+  bool operator()(const Delivery* a, const Delivery* b) const {
+    if(a->arrival!=b->arrival) return a->arrival > b->arrival;
+    return a->src_uid > b->src_uid;
+  }
+};
+
+// Exports contend for the channel before they go out: a sender backs off a
+// random number of slots, then checks the channel; while it hears the
+// channel busy it backs off again from a window that doubles each time,
+// giving up after a retry limit.  Packets whose air time overlaps another
+// packet at the same receiver collide.  Deliveries are queued on the
+// receiver and handed to its VM, in order of arrival, just before its next
+// compute, with lag set to the time since the export was sent.
+// Transmissions are reserved in the order exports happen, so a later
+// export never pre-empts one that has already claimed the channel.
+class CsmaRadio : public RadioSim {
+ public:
+  // model options
+  METERS range, r_sqr;       // radius of transmission (in meters) [and sq]
+  flo bitrate;               // bits per second
+  int header_bytes;          // framing added to each export
+  SECONDS slot;              // backoff slot length
+  int cw_min, cw_max, max_retries;
+  // display options
+  bool is_show_radio;
+
+  CsmaRadio(Args* args, SpatialComputer* parent, int n);
+  ~CsmaRadio();
+  bool handle_key(KeyEvent* key);
+  void add_device(Device* d);
+  void device_moved(Device* d);
+  void dump_header(FILE* out);
+
+  // hardware emulation
+  Number read_radio_range ();
+  int radio_send_export (uint8_t version, Array<Data> const & data);
+  int radio_send_script_pkt (uint8_t version, uint16_t n,
+                             uint8_t pkt_num, uint8_t *script);
+  int radio_send_digest (uint8_t version, uint16_t script_len,
+                         uint8_t *digest);
+
+  friend class CsmaDevice;
+ protected:
+  CellIndex* cells; // cells are collections of Device pointers
+  void in_range(const flo* p, vector<Device*>* out);
+
+  virtual void register_colors();
+  static Color *RADIO_RANGE_RING;
+};
+
+class CsmaDevice : public DeviceLayer {
+ public:
+  CsmaRadio* parent;
+  // these values are actually managed by the CsmaRadio
+  Population* cell; // which cell the device was last in (before motion)
+  int cell_loc; // where is the device in its cell's list
+  SECONDS busy_until; // end of the last transmission this device can hear
+  SECONDS tx_until;   // end of this device's own transmission
+  SECONDS rx_until;   // end of the packet this device is receiving
+  Delivery* receiving; // that packet, so a collision can spoil it
+  // deliveries not yet handed to the VM, earliest arrival on top
+  priority_queue<Delivery*,vector<Delivery*>,LaterArrival> pending;
+  int last_backoff; // slots waited before the last transmission
+  int sent, backoffs, collisions, dropped; // counters, for dumps
+
+  CsmaDevice(CsmaRadio* parent, Device* container);
+  ~CsmaDevice();
+  void preupdate(); // deliver everything that has arrived
+  void visualize();
+  void copy_state(DeviceLayer* src) {} // to be called during cloning
+  void dump_state(FILE* out, int verbosity);
+};
+
+#endif // __CSMARADIO__
@@ -0,0 +1,347 @@
+/* Radio simulation with a separate transmit range for each device
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include "hetero-radio.h"
+#include "visualizer.h"
+
+#define SET_RADIO_RANGE_OP "set-radio-range scalar scalar"
+
+/*****************************************************************************
+ *  HETEROGENEOUS RANGE RADIO                                                *
+ *****************************************************************************/
+HeteroRadio::HeteroRadio(Args* args, SpatialComputer* p, int n)
+  : RadioSim(args, p) {
+  ensure_colors_registered("HeteroRadio");
+  default_range = (args->extract_switch("-r"))?args->pop_number():15.0;
+  max_range = default_range;
+  if(args->extract_switch("-range-classes")) { // K r1 w1 ... rK wK
+    int k = (int)args->pop_number();
+    for(int i=0;i<k;i++) {
+      class_range.push_back(args->pop_number());
+      class_weight.push_back(args->pop_number());
+      max_range = max(max_range,class_range[i]);
+    }
+  }
+  uniform_min = uniform_max = 0;
+  if(args->extract_switch("-range-uniform")) {
+    uniform_min = args->pop_number(); uniform_max = args->pop_number();
+    if(class_range.size())
+      post("WARNING: '-range-uniform' overridden by '-range-classes'");
+    else
+      max_range = max(max_range,uniform_max);
+  }
+  // display options
+  is_show_radio = args->extract_switch("-show-radio");
+  is_fast_prune_hood = !args->extract_switch("-no-motion-pruning");
+  args->undefault(&can_dump,"-Dradio","-NDradio");
+  // register hardware patches
+  p->hardware.patch(this,READ_RADIO_RANGE_FN);
+  p->hardware.patch(this,RADIO_SEND_EXPORT_FN);
+  p->hardware.patch(this,RADIO_SEND_SCRIPT_PKT_FN);
+  p->hardware.patch(this,RADIO_SEND_DIGEST_FN);
+  p->hardware.registerOpcode(new OpHandler<HeteroRadio>(this, &HeteroRadio::set_range_op, SET_RADIO_RANGE_OP));
+
+  cells = new CellIndex(parent->volume,max_range);
+}
+
+HeteroRadio::~HeteroRadio() {
+  delete cells; // populations assumed empty
+}
+
+Color *HeteroRadio::RADIO_RANGE_RING;
+void HeteroRadio::register_colors() {
+#ifdef WANT_GLUT
+  RADIO_RANGE_RING =
+    palette->register_color("RADIO_RANGE_RING", 0.25, 0.25, 0.25, 0.8);
+#endif
+}
+
+bool HeteroRadio::handle_key(KeyEvent* key) {
+  if(key->normal && !key->ctrl) {
+    METERS delta = 0;
+    switch(key->key) {
+    case 'r': is_show_radio = !is_show_radio; return true;
+    case 'R': delta = 1; break;
+    case 'E': delta = -1; break;
+    }
+    if(delta) { // adjust the range of the selected devices
+      for(int i=0;i<parent->devices.max_id();i++) {
+        Device* d = (Device*)parent->devices.get(i);
+        if(d && d->is_selected) {
+          HeteroRadioDevice* hd = (HeteroRadioDevice*)d->layers[id];
+          set_range(d,max((METERS)0,hd->range+delta));
+        }
+      }
+      return true;
+    }
+  }
+  return RadioSim::handle_key(key);
+}
+
+void HeteroRadio::dump_header(FILE* out) {
+  if(can_dump) fprintf(out," \"RANGE\" \"HEARD-BY\" \"HEARS\"");
+}
+
+METERS HeteroRadio::initial_range() {
+  if(class_range.size()) {
+    flo total = 0;
+    for(int i=0;i<class_weight.size();i++) total += class_weight[i];
+    flo pick = urnd(0,total);
+    for(int i=0;i<class_range.size();i++) {
+      if(pick < class_weight[i]) return class_range[i];
+      pick -= class_weight[i];
+    }
+    return class_range.back();
+  }
+  if(uniform_min < uniform_max) return urnd(uniform_min,uniform_max);
+  return default_range;
+}
+
+// called when max_range has outgrown the cells: the links themselves are
+// unaffected, only the bucketing changes
+void HeteroRadio::rebuild_cells() {
+  delete cells;
+  cells = new CellIndex(parent->volume,max_range);
+  for(int i=0;i<parent->devices.max_id();i++) {
+    Device* d = (Device*)parent->devices.get(i); if(d==NULL) continue;
+    HeteroRadioDevice* hd = (HeteroRadioDevice*)d->layers[id];
+    hd->cell = cells->cell_at(d->body->position());
+    hd->cell_loc = hd->cell->add(d);
+  }
+}
+
+// squared distance between two points
+static flo dist3sqr(const flo* a, const flo* b) {
+  flo dx = a[0]-b[0], dy = a[1]-b[1], dz = a[2]-b[2];
+  return dx*dx + dy*dy + dz*dz;
+}
+
+void HeteroRadio::connect_out(HeteroRadioDevice* hd) {
+  const flo* p = hd->container->body->position();
+  flo r_sqr = hd->range*hd->range;
+  vector<Population*> near;
+  cells->cells_near(p,hd->range,&near);
+  for(int c=0;c<near.size();c++) {
+    for(int i=0;i<near[c]->max_id();i++) {
+      Device* nbrd = (Device*)near[c]->get(i);
+      if(nbrd==NULL || nbrd==hd->container) continue;
+      if(dist3sqr(p,nbrd->body->position()) < r_sqr) {
+        HeteroRadioDevice* nbr = (HeteroRadioDevice*)nbrd->layers[id];
+        hd->out.insert(nbr); nbr->in.insert(hd);
+      }
+    }
+  }
+}
+
+// a device can hear anything whose range covers it, so the search has to
+// reach as far as the largest range in use
+void HeteroRadio::connect_device(Device* d) {
+  HeteroRadioDevice* hd = (HeteroRadioDevice*)d->layers[id];
+  const flo* p = d->body->position();
+  flo r_sqr = hd->range*hd->range;
+  vector<Population*> near;
+  cells->cells_near(p,max_range,&near);
+  for(int c=0;c<near.size();c++) {
+    for(int i=0;i<near[c]->max_id();i++) {
+      Device* nbrd = (Device*)near[c]->get(i);
+      if(nbrd==NULL) continue;
+      HeteroRadioDevice* nbr = (HeteroRadioDevice*)nbrd->layers[id];
+      flo d2 = dist3sqr(p,nbrd->body->position());
+      if(d2 < r_sqr) { hd->out.insert(nbr); nbr->in.insert(hd); }
+      if(d2 < nbr->range*nbr->range) { nbr->out.insert(hd); hd->in.insert(nbr); }
+    }
+  }
+  hd->cell = cells->cell_at(p);
+  hd->cell_loc = hd->cell->add(d);
+}
+
+void HeteroRadio::disconnect_out(HeteroRadioDevice* hd) {
+  for(set<HeteroRadioDevice*>::iterator i=hd->out.begin();i!=hd->out.end();i++)
+    (*i)->in.erase(hd);
+  hd->out.clear();
+}
+
+void HeteroRadio::disconnect_device(Device* d) {
+  HeteroRadioDevice* hd = (HeteroRadioDevice*)d->layers[id];
+  disconnect_out(hd);
+  for(set<HeteroRadioDevice*>::iterator i=hd->in.begin();i!=hd->in.end();i++)
+    (*i)->out.erase(hd);
+  hd->in.clear();
+  Device* removed = (Device*)cells->remove(hd->cell,hd->cell_loc);
+  if(removed!=d) { debug("Bad back cell reference!\n"); }
+}
+
+void HeteroRadio::add_device(Device* d) {
+  d->layers[id] = new HeteroRadioDevice(this,d,initial_range());
+  connect_device(d);
+}
+
+void HeteroRadio::set_range(Device* d, METERS range) {
+  HeteroRadioDevice* hd = (HeteroRadioDevice*)d->layers[id];
+  if(range==hd->range) return; // the op is usually re-asserted every round
+  hd->range = range;
+  if(range > max_range) {
+    max_range = range;
+    if(max_range > 2*cells->cell_size()) rebuild_cells();
+  }
+  set<HeteroRadioDevice*> old_out; old_out.swap(hd->out);
+  for(set<HeteroRadioDevice*>::iterator i=old_out.begin();i!=old_out.end();i++)
+    (*i)->in.erase(hd);
+  connect_out(hd);
+  if(is_fast_prune_hood) { // devices that lost us drop our hood entry
+    for(set<HeteroRadioDevice*>::iterator i=old_out.begin();
+        i!=old_out.end();i++) {
+      if(hd->out.count(*i)) continue;
+      Machine* nvm = (*i)->container->vm;
+      NeighbourHood::iterator nbr = nvm->hood.find(d->uid);
+      if (nbr != nvm->hood.end()) nvm->hood.remove(nbr);
+    }
+  }
+}
+
+void HeteroRadio::set_range_op(Machine* machine) {
+  set_range(device,Number_toDouble(machine->stack.peek().asNumber()));
+}
+
+// delete the VM hood entries of devices no longer heard
+void HeteroRadio::prune_hood(Device* d) {
+  for(NeighbourHood::iterator i = d->vm->hood.begin(); i != d->vm->hood.end(); i++){
+    i->in_range = false;
+  }
+  d->vm->thisMachine().in_range = true;
+  HeteroRadioDevice* hd = (HeteroRadioDevice*)d->layers[id];
+  for(set<HeteroRadioDevice*>::iterator i=hd->in.begin();i!=hd->in.end();i++) {
+    NeighbourHood::iterator nbr = d->vm->hood.find((*i)->container->uid);
+    if (nbr != d->vm->hood.end()) nbr->in_range = true;
+  }
+  for(NeighbourHood::iterator i = d->vm->hood.begin(); i != d->vm->hood.end(); ){
+    if (i->in_range) {
+      i++;
+    } else {
+      i = d->vm->hood.remove(i);
+    }
+  }
+}
+
+void HeteroRadio::device_moved(Device* d) {
+  disconnect_device(d); connect_device(d);
+  if(is_fast_prune_hood) prune_hood(d);
+}
+
+/*****************************************************************************
+ *  HARDWARE EMULATION                                                       *
+ *****************************************************************************/
+Number HeteroRadio::read_radio_range () {
+  return ((HeteroRadioDevice*)device->layers[id])->range;
+}
+
+int HeteroRadio::radio_send_export (uint8_t version, Array<Data> const & data) {
+  if(!try_tx())  // transmission failure
+    return 0;
+
+  int src_id = device->uid;
+  const flo* me = device->body->position();
+  HeteroRadioDevice* hd = (HeteroRadioDevice*)device->layers[id];
+  vector<bool> const * changed = delta_of(device);
+  for(set<HeteroRadioDevice*>::iterator i=hd->out.begin();i!=hd->out.end();i++) {
+    if(try_rx()) { // non-failing receive
+      const flo* them = (*i)->container->body->position();
+      Neighbour* nbr =
+        receive_export((*i)->container->vm,src_id,version,data,changed);
+      if(!nbr) continue; // delta without a fresh base
+      nbr->x = me[0]-them[0];
+      nbr->y = me[1]-them[1];
+      nbr->z = me[2]-them[2];
+    }
+  }
+  return 1;
+}
+
+bool HeteroRadio::list_receivers(vector<Reception>* out) {
+  const flo* me = device->body->position();
+  HeteroRadioDevice* hd = (HeteroRadioDevice*)device->layers[id];
+  for(set<HeteroRadioDevice*>::iterator i=hd->out.begin();i!=hd->out.end();i++) {
+    const flo* them = (*i)->container->body->position();
+    Reception r; r.rx = (*i)->container;
+    for(int j=0;j<3;j++) r.dp[j] = me[j]-them[j];
+    out->push_back(r);
+  }
+  return true;
+}
+
+// scripts are not transmitted in the simulator (see UnitDiscRadio)
+int HeteroRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
+                                        uint8_t pkt_num, uint8_t *script) {
+  return 0;
+}
+
+int HeteroRadio::radio_send_digest (uint8_t version, uint16_t script_len,
+                                    uint8_t *digest) {
+  return 0;
+}
+
+/*****************************************************************************
+ *  PER-DEVICE STATE                                                         *
+ *****************************************************************************/
+HeteroRadioDevice::HeteroRadioDevice(HeteroRadio* parent, Device* container,
+                                     METERS range)
+  : DeviceLayer(container) { this->parent = parent; this->range = range; }
+
+HeteroRadioDevice::~HeteroRadioDevice() {
+  if(parent->is_fast_prune_hood) { // delete self from each hearer
+    for(set<HeteroRadioDevice*>::iterator i=out.begin();i!=out.end();i++) {
+      Machine* nvm = (*i)->container->vm;
+      NeighbourHood::iterator nbr = nvm->hood.find(container->uid);
+      if (nbr != nvm->hood.end()) nvm->hood.remove(nbr);
+    }
+  }
+  parent->disconnect_device(container);
+}
+
+void HeteroRadioDevice::copy_state(DeviceLayer* src) {
+  parent->set_range(container,((HeteroRadioDevice*)src)->range);
+}
+
+void HeteroRadioDevice::dump_state(FILE* fp, int verbosity) {
+  if(verbosity==0) {
+    fprintf(fp," %.2f %d %d",range,(int)out.size(),(int)in.size());
+  } else {
+    fprintf(fp,"Range = %.2f, Heard by = %d, Hears = %d\n",range,
+            (int)out.size(),(int)in.size());
+  }
+}
+
+void HeteroRadioDevice::visualize() {
+#ifdef WANT_GLUT
+  if(parent->is_show_radio) { // draw this device's range
+    palette->use_color(HeteroRadio::RADIO_RANGE_RING);
+    draw_circle(range);
+  }
+  if(parent->is_show_connectivity) { // draw outgoing links
+    bool local_sharp=(parent->connect_display_mode==1 &&
+                      container->is_selected);
+    if(parent->connect_display_mode==2 || local_sharp) {
+      palette->use_color(RadioSim::NET_CONNECTION_SHARP);
+      glLineWidth(1);
+    } else {
+      palette->use_color(RadioSim::NET_CONNECTION_FUZZY);
+      glLineWidth(4);
+    }
+    glBegin(GL_LINES);
+    const flo* me = container->body->position();
+    for(set<HeteroRadioDevice*>::iterator i=out.begin();i!=out.end();i++) {
+      const flo* them = (*i)->container->body->position();
+      glVertex3f(0,0,0);
+      glVertex3f(them[0]-me[0], them[1]-me[1], them[2]-me[2]);
+    }
+    glEnd();
+    glLineWidth(1);
+  }
+#endif // WANT_GLUT
+}
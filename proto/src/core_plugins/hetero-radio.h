@@ -0,0 +1,90 @@
+/* Radio simulation with a separate transmit range for each device
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __HETERORADIO__
+#define __HETERORADIO__
+
+#include "proto_plugin.h"
+#include "spatialcomputer.h"
+#include "radio.h"
+#include "spatialindex.h"
+#include <set>
+using namespace std;
+
+class HeteroRadioDevice;
+
+// Like UnitDiscRadio, but each device transmits to its own range, so
+// links are directed: A hears B when A is within B's range.
+class HeteroRadio : public RadioSim {
+ public:
+  // model options
+  METERS default_range;      // range for devices not otherwise assigned
+  METERS max_range;          // largest range any device has had
+  vector<METERS> class_range; // -range-classes: ranges and their weights
+  vector<flo> class_weight;
+  METERS uniform_min, uniform_max; // -range-uniform: used if min < max
+  // display options
+  bool is_show_radio;
+  bool is_fast_prune_hood;  // prune the VM neighborhood on movement?
+
+  HeteroRadio(Args* args, SpatialComputer* parent, int n);
+  ~HeteroRadio();
+  bool handle_key(KeyEvent* key);
+  void add_device(Device* d);
+  void device_moved(Device* d);
+  void dump_header(FILE* out);
+
+  // change the transmit range of one device, updating only its out-links
+  void set_range(Device* d, METERS range);
+
+  // hardware emulation
+  Number read_radio_range ();
+  int radio_send_export (uint8_t version, Array<Data> const & data);
+  int radio_send_script_pkt (uint8_t version, uint16_t n,
+                             uint8_t pkt_num, uint8_t *script);
+  int radio_send_digest (uint8_t version, uint16_t script_len,
+                         uint8_t *digest);
+  bool list_receivers(vector<Reception>* out);
+
+  friend class HeteroRadioDevice;
+ protected:
+  // storage: cells are at least half the maximum range, so a query
+  // never has to look more than two cells out
+  CellIndex* cells;
+  METERS initial_range(); // draw a range from the configured distribution
+  void rebuild_cells();
+  void connect_out(HeteroRadioDevice* d); // links from d to those it reaches
+  void connect_device(Device* d); // create all links, both directions
+  void disconnect_out(HeteroRadioDevice* d);
+  void disconnect_device(Device* d); // delete all links
+  void prune_hood(Device* d);
+
+  void set_range_op(Machine* machine);
+
+  virtual void register_colors();
+  static Color *RADIO_RANGE_RING;
+};
+
+class HeteroRadioDevice : public DeviceLayer {
+ public:
+  HeteroRadio* parent;
+  METERS range;
+  // these values are actually managed by the HeteroRadio
+  set<HeteroRadioDevice*> out; // devices that hear this one
+  set<HeteroRadioDevice*> in;  // devices this one hears
+  Population* cell; // which cell the device was last in (before motion)
+  int cell_loc; // where is the device in its cell's list
+
+  HeteroRadioDevice(HeteroRadio* parent, Device* container, METERS range);
+  ~HeteroRadioDevice();
+  void visualize();
+  void copy_state(DeviceLayer* src); // to be called during cloning
+  void dump_state(FILE* out, int verbosity);
+};
+
+#endif // __HETERORADIO__
@@ -7,13 +7,14 @@ This file is part of MIT Proto, and is distributed under the terms of
 the GNU General Public License, with a linking exception, as described
 in the file LICENSE in the MIT Proto distribution's top directory.  */
 
-// WARNING: currently broken... but at least we can load the plugin.
 #include "config.h"
 #include "multiradio.h"
 #include "plugin_manager.h"
 #include <algorithm>
 
 MultiRadio::MultiRadio(Args *args,SpatialComputer *p,int n) : RadioSim(args, p){
+  n_sends = 0;
+  args->undefault(&can_dump,"-Dmultiradio","-NDmultiradio");
   while(args->extract_switch("-radio",false)) {
     string r = args->pop_next();
     RadioSim* rs = (RadioSim*)plugins.get_sim_plugin(LAYER_PLUGIN,r,args,p,n);
@@ -33,6 +34,7 @@ void MultiRadio::add_radio(RadioSim *r) {
   }
   
   radios.push_back(r);
+  parent->addLayer(r); // so it tracks devices like any layer
 
   r->tx_error = tx_error;
   r->rx_error = rx_error;
@@ -62,15 +64,44 @@ bool MultiRadio::handle_key(KeyEvent *key) {
   return handled;
 }
 
-void MultiRadio::add_device(Device *d) {}
+void MultiRadio::add_device(Device *d) {
+  d->layers[id] = new MultiRadioDevice(this,d);
+}
 
 void MultiRadio::device_moved(Device *d) {}
 
+void MultiRadio::dump_header(FILE* out) {
+  if(!can_dump) return;
+  for(size_t r=0;r<radios.size();r++) fprintf(out," \"VIA-%d\"",(int)r+1);
+  fprintf(out," \"DUPLICATES\"");
+}
+
 int MultiRadio::radio_send_export (uint8_t version, Array<Data> const & data){
-  typeof(radios.begin()) it;
-  for(it = radios.begin(); it != radios.end(); it++) {
-    (*it)->radio_send_export(version, data);
+  n_sends++;
+  int src_id = device->uid, sent = 0;
+  vector<bool> const * changed = delta_of(device);
+  for(size_t r=0;r<radios.size();r++) {
+    RadioSim* rs = radios[r];
+    heard.clear();
+    if(!rs->list_receivers(&heard)) // it has to deliver by itself
+      { sent |= rs->radio_send_export(version, data); continue; }
+    if(!rs->try_tx()) continue; // transmission failure on this radio
+    sent = 1;
+    for(size_t i=0;i<heard.size();i++) {
+      if(!rs->try_rx()) continue;
+      Device* rx = heard[i].rx;
+      MultiRadioDevice* mrx = (MultiRadioDevice*)rx->layers[id];
+      if(mrx->last_heard == n_sends) { mrx->duplicates++; continue; }
+      mrx->last_heard = n_sends;
+      Neighbour* nbr = receive_export(rx->vm,src_id,version,data,changed);
+      if(!nbr) continue; // delta without a fresh base
+      nbr->x = heard[i].dp[0];
+      nbr->y = heard[i].dp[1];
+      nbr->z = heard[i].dp[2];
+      mrx->via[r]++;
+    }
   }
+  return sent; // did any radio get it on the air?
 }
 
 int MultiRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
@@ -79,6 +110,7 @@ int MultiRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
   for(it = radios.begin(); it != radios.end(); it++) {
     (*it)->radio_send_script_pkt(version, n, pkt_num, script);
   }*/
+  return 0;
 }
 
 int MultiRadio::radio_send_digest (uint8_t version, uint16_t script_len,
@@ -87,4 +119,21 @@ int MultiRadio::radio_send_digest (uint8_t version, uint16_t script_len,
   for(it = radios.begin(); it != radios.end(); it++) {
     (*it)->radio_send_digest(version, script_len, digest);
   }*/
+  return 0;
+}
+
+MultiRadioDevice::MultiRadioDevice(MultiRadio* parent, Device* container)
+  : DeviceLayer(container), via(parent->radios.size(),0) {
+  last_heard = 0; duplicates = 0;
+}
+
+void MultiRadioDevice::dump_state(FILE* fp, int verbosity) {
+  if(verbosity==0) {
+    for(size_t r=0;r<via.size();r++) fprintf(fp," %ld",via[r]);
+    fprintf(fp," %ld",duplicates);
+  } else {
+    fprintf(fp,"Received via radio:");
+    for(size_t r=0;r<via.size();r++) fprintf(fp," %d: %ld",(int)r+1,via[r]);
+    fprintf(fp,", duplicates %ld\n",duplicates);
+  }
 }
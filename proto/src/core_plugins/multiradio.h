@@ -13,6 +13,13 @@ in the file LICENSE in the MIT Proto distribution's top directory.  */
 #include "radio.h"
 #include <vector>
 
+// Superposes several radios, given by -radio NAME (repeatable).  Each
+// is a layer in its own right, tracking its own devices.  Exports are
+// delivered once per receiver however many radios reach it: each radio
+// that can list its receivers applies its own loss, and the first to
+// reach a receiver delivers.  Radios that cannot list receivers send on
+// their own.  -Dmultiradio dumps, per receiver, how many exports arrived
+// via each radio and how many duplicates were suppressed.
 class MultiRadio : public RadioSim {
 public:
   MultiRadio(Args *args, SpatialComputer *parent, int n);
@@ -23,6 +30,7 @@ public:
   bool handle_key(KeyEvent* key);
   void add_device(Device* d);
   void device_moved(Device *d);
+  void dump_header(FILE* out);
 
   int radio_send_export (uint8_t version, Array<Data> const & n);
   int radio_send_script_pkt (uint8_t version, uint16_t n, 
@@ -34,6 +42,21 @@ private:
   void update_patches();
 
   std::vector<RadioSim*> radios;
+  std::vector<Reception> heard; // scratch space for list_receivers
+  long n_sends;                 // stamps receivers already delivered to
+
+  friend class MultiRadioDevice;
+};
+
+class MultiRadioDevice : public DeviceLayer {
+ public:
+  long last_heard;              // send stamp of the last delivery here
+  std::vector<long> via;        // deliveries attributed to each radio
+  long duplicates;              // deliveries suppressed as repeats
+
+  MultiRadioDevice(MultiRadio* parent, Device* container);
+  void copy_state(DeviceLayer* src) {} // to be called during cloning
+  void dump_state(FILE* out, int verbosity);
 };
 
 #endif
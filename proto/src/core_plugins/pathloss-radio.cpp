@@ -0,0 +1,235 @@
+/* Log-distance path loss radio simulation with SINR-based reception
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include "pathloss-radio.h"
+#include "visualizer.h"
+
+#define SHADOW_BOUND 3 // shadowing is clipped to +/- this many sigma
+
+/*****************************************************************************
+ *  PATH LOSS RADIO                                                          *
+ *****************************************************************************/
+PathLossRadio::PathLossRadio(Args* args, SpatialComputer* p, int n)
+  : RadioSim(args, p) {
+  ensure_colors_registered("PathLossRadio");
+  tx_power = (args->extract_switch("-tx-power"))?args->pop_number():0;
+  pl0 = (args->extract_switch("-pl0"))?args->pop_number():40;
+  exponent = (args->extract_switch("-pl-exponent"))?args->pop_number():3;
+  shadow_sigma = (args->extract_switch("-shadowing"))?args->pop_number():4;
+  noise = (args->extract_switch("-noise"))?args->pop_number():-100;
+  sensitivity = (args->extract_switch("-sensitivity"))?args->pop_number():-75;
+  sinr_threshold = (args->extract_switch("-sinr"))?args->pop_number():10;
+  window = (args->extract_switch("-interference-window"))?
+    args->pop_number():0.01;
+  // display options
+  is_show_radio = args->extract_switch("-show-radio");
+  args->undefault(&can_dump,"-Dradio","-NDradio");
+  // register hardware patches
+  p->hardware.patch(this,READ_RADIO_RANGE_FN);
+  p->hardware.patch(this,RADIO_SEND_EXPORT_FN);
+  p->hardware.patch(this,RADIO_SEND_SCRIPT_PKT_FN);
+  p->hardware.patch(this,RADIO_SEND_DIGEST_FN);
+
+  // distances at which the link budget runs out
+  flo budget = tx_power - pl0, margin = SHADOW_BOUND*shadow_sigma;
+  nominal_range = pow(10,(budget-sensitivity)/(10*exponent));
+  reach = pow(10,(budget-sensitivity+margin)/(10*exponent));
+  interference_reach = pow(10,(budget-noise+margin)/(10*exponent));
+  shadow_salt = (unsigned int)urnd(0,65536);
+  devices = new CellIndex(parent->volume,reach);
+  interferers = new CellIndex(parent->volume,interference_reach);
+}
+
+PathLossRadio::~PathLossRadio() {
+  expire(HUGE_VAL);
+  delete devices; delete interferers; // populations assumed empty
+}
+
+Color *PathLossRadio::RADIO_RANGE_RING;
+void PathLossRadio::register_colors() {
+#ifdef WANT_GLUT
+  RADIO_RANGE_RING =
+    palette->register_color("RADIO_RANGE_RING", 0.25, 0.25, 0.25, 0.8);
+#endif
+}
+
+bool PathLossRadio::handle_key(KeyEvent* key) {
+  if(key->normal && !key->ctrl) {
+    switch(key->key) {
+    case 'r': is_show_radio = !is_show_radio; return true;
+    }
+  }
+  return RadioSim::handle_key(key);
+}
+
+void PathLossRadio::dump_header(FILE* out) {
+  if(can_dump) fprintf(out," \"RECEIVED\" \"LOST-SINR\"");
+}
+
+void PathLossRadio::add_device(Device* d) {
+  PathLossDevice* pd = new PathLossDevice(this,d);
+  d->layers[id] = pd;
+  pd->cell = devices->cell_at(d->body->position());
+  pd->cell_loc = pd->cell->add(d);
+}
+
+void PathLossRadio::device_moved(Device* d) {
+  PathLossDevice* pd = (PathLossDevice*)d->layers[id];
+  Population* c = devices->cell_at(d->body->position());
+  if(c==pd->cell) return;
+  devices->remove(pd->cell,pd->cell_loc);
+  pd->cell = c; pd->cell_loc = c->add(d);
+}
+
+// squared distance between two points
+static flo dist3sqr(const flo* a, const flo* b) {
+  flo dx = a[0]-b[0], dy = a[1]-b[1], dz = a[2]-b[2];
+  return dx*dx + dy*dy + dz*dz;
+}
+
+flo PathLossRadio::path_loss(flo dist_sqr) {
+  if(dist_sqr < 1) dist_sqr = 1; // the model is only good past d0 = 1m
+  return pl0 + 5*exponent*log10(dist_sqr); // 10*n*log10(d)
+}
+
+// A fixed Gaussian draw for each unordered pair, so that a link keeps its
+// shadowing for the whole run without storing it
+flo PathLossRadio::shadowing(int a, int b) {
+  if(shadow_sigma==0) return 0;
+  if(a > b) { int t = a; a = b; b = t; }
+  unsigned int h = shadow_salt;
+  h ^= a*2654435761u; h = (h^(h>>16))*0x45d9f3b;
+  h ^= b*2246822519u; h = (h^(h>>16))*0x45d9f3b; h ^= h>>16;
+  flo u1 = ((h & 0xffff)+1)/65537.0, u2 = ((h>>16)+1)/65537.0;
+  flo g = sqrt(-2*log(u1))*cos(2*M_PI*u2);
+  g = max((flo)-SHADOW_BOUND,min((flo)SHADOW_BOUND,g));
+  return g*shadow_sigma;
+}
+
+flo PathLossRadio::received_power(int src, const flo* sp,
+                                  int dst, const flo* dp) {
+  return tx_power - path_loss(dist3sqr(sp,dp)) - shadowing(src,dst);
+}
+
+void PathLossRadio::expire(SECONDS now) {
+  while(!recent.empty() && recent.front()->time < now-window) {
+    Transmission* t = recent.front(); recent.pop_front();
+    interferers->remove(t->cell,t->cell_loc);
+    delete t;
+  }
+}
+
+// charge the signal against noise plus every transmission still in the
+// window that is near enough to the receiver to matter; those sent at this
+// same instant, as a synchronous round's are, do not count, whichever of
+// them went out first
+bool PathLossRadio::sinr_ok(flo signal, int src, int dst, const flo* dp) {
+  flo interference = pow(10,noise/10); // in mW
+  vector<Population*> near;
+  interferers->cells_near(dp,interference_reach,&near);
+  for(int c=0;c<near.size();c++) {
+    for(int i=0;i<near[c]->max_id();i++) {
+      Transmission* t = (Transmission*)near[c]->get(i);
+      if(t==NULL || t->src_uid==src || t->src_uid==dst) continue;
+      if(t->time==parent->sim_time) continue;
+      interference += pow(10,received_power(t->src_uid,t->pos,dst,dp)/10);
+    }
+  }
+  return signal - 10*log10(interference) >= sinr_threshold;
+}
+
+/*****************************************************************************
+ *  HARDWARE EMULATION                                                       *
+ *****************************************************************************/
+Number PathLossRadio::read_radio_range () { return nominal_range; }
+
+int PathLossRadio::radio_send_export (uint8_t version, Array<Data> const & data) {
+  SECONDS now = parent->sim_time;
+  expire(now);
+  if(!try_tx())  // transmission failure
+    return 0;
+  ((PathLossDevice*)device->layers[id])->last_tx = now;
+
+  int src_id = device->uid;
+  const flo* me = device->body->position();
+  vector<Population*> near;
+  devices->cells_near(me,reach,&near);
+  for(int c=0;c<near.size();c++) {
+    for(int i=0;i<near[c]->max_id();i++) {
+      Device* rd = (Device*)near[c]->get(i);
+      if(rd==NULL || rd==device) continue;
+      PathLossDevice* rpd = (PathLossDevice*)rd->layers[id];
+      // a receiver is deaf while its own transmission, begun earlier, is on
+      // the air
+      if(rpd->last_tx < now && now-rpd->last_tx < window) continue;
+      const flo* them = rd->body->position();
+      flo signal = received_power(src_id,me,rd->uid,them);
+      if(signal < sensitivity) continue;
+      if(!sinr_ok(signal,src_id,rd->uid,them)) { rpd->lost_sinr++; continue; }
+      if(try_rx()) { // non-failing receive
+        Neighbour* nbr =
+          receive_export(rd->vm,src_id,version,data,delta_of(device));
+        if(!nbr) continue; // delta without a fresh base
+        nbr->x = me[0]-them[0];
+        nbr->y = me[1]-them[1];
+        nbr->z = me[2]-them[2];
+        rpd->received++;
+      }
+    }
+  }
+  // this transmission now interferes with those that follow it
+  Transmission* t = new Transmission();
+  t->src_uid = src_id; t->time = now;
+  for(int i=0;i<3;i++) t->pos[i] = me[i];
+  t->cell = interferers->cell_at(me); t->cell_loc = t->cell->add(t);
+  recent.push_back(t);
+  return 1;
+}
+
+// scripts are not transmitted in the simulator (see UnitDiscRadio)
+int PathLossRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
+                                          uint8_t pkt_num, uint8_t *script) {
+  return 0;
+}
+
+int PathLossRadio::radio_send_digest (uint8_t version, uint16_t script_len,
+                                      uint8_t *digest) {
+  return 0;
+}
+
+/*****************************************************************************
+ *  PER-DEVICE STATE                                                         *
+ *****************************************************************************/
+PathLossDevice::PathLossDevice(PathLossRadio* parent, Device* container)
+  : DeviceLayer(container) {
+  this->parent = parent; last_tx = -HUGE_VAL; received = lost_sinr = 0;
+}
+
+PathLossDevice::~PathLossDevice() {
+  Device* removed = (Device*)parent->devices->remove(cell,cell_loc);
+  if(removed!=container) { debug("Bad back cell reference!\n"); }
+}
+
+void PathLossDevice::dump_state(FILE* fp, int verbosity) {
+  if(verbosity==0) {
+    fprintf(fp," %d %d",received,lost_sinr);
+  } else {
+    fprintf(fp,"Received = %d, Lost to interference = %d\n",received,
+            lost_sinr);
+  }
+}
+
+void PathLossDevice::visualize() {
+#ifdef WANT_GLUT
+  if(parent->is_show_radio) { // draw the nominal range
+    palette->use_color(PathLossRadio::RADIO_RANGE_RING);
+    draw_circle(parent->nominal_range);
+  }
+#endif // WANT_GLUT
+}
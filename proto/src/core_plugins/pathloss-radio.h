@@ -0,0 +1,93 @@
+/* Log-distance path loss radio simulation with SINR-based reception
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __PATHLOSSRADIO__
+#define __PATHLOSSRADIO__
+
+#include "proto_plugin.h"
+#include "spatialcomputer.h"
+#include "radio.h"
+#include "spatialindex.h"
+#include <deque>
+using namespace std;
+
+// A transmission still inside the interference window
+struct Transmission {
+  int src_uid;
+  METERS pos[3];
+  SECONDS time;
+  Population* cell; int cell_loc; // where it is in the interferer index
+};
+
+// Received power falls off as pl0 + 10*exponent*log10(d) dB, plus a fixed
+// log-normal shadowing term per pair of devices.  A packet is received if
+// it is above the sensitivity and its SINR against the noise floor plus
+// every other transmission in the last window clears the threshold.
+// Interference is only charged to packets sent later than the interferer,
+// and a device only misses packets sent after it began transmitting.
+class PathLossRadio : public RadioSim {
+ public:
+  // model options (powers in dBm, losses in dB)
+  flo tx_power, pl0, exponent, shadow_sigma, noise, sensitivity;
+  flo sinr_threshold;
+  SECONDS window;
+  // display options
+  bool is_show_radio;
+
+  PathLossRadio(Args* args, SpatialComputer* parent, int n);
+  ~PathLossRadio();
+  bool handle_key(KeyEvent* key);
+  void add_device(Device* d);
+  void device_moved(Device* d);
+  void dump_header(FILE* out);
+
+  // hardware emulation
+  Number read_radio_range ();
+  int radio_send_export (uint8_t version, Array<Data> const & data);
+  int radio_send_script_pkt (uint8_t version, uint16_t n,
+                             uint8_t pkt_num, uint8_t *script);
+  int radio_send_digest (uint8_t version, uint16_t script_len,
+                         uint8_t *digest);
+
+  friend class PathLossDevice;
+ protected:
+  METERS nominal_range;      // mean received power == sensitivity
+  METERS reach;              // furthest any packet can be received
+  METERS interference_reach; // furthest an interferer is above the noise
+  unsigned int shadow_salt;  // varies the shadowing map with the seed
+  CellIndex* devices;        // receivers, cells sized by reach
+  CellIndex* interferers;    // recent Transmissions
+  deque<Transmission*> recent; // in time order, for expiry
+
+  flo path_loss(flo dist_sqr);
+  flo shadowing(int a, int b);
+  flo received_power(int src, const flo* sp, int dst, const flo* dp);
+  void expire(SECONDS now);
+  bool sinr_ok(flo signal, int src, int dst, const flo* dp);
+
+  virtual void register_colors();
+  static Color *RADIO_RANGE_RING;
+};
+
+class PathLossDevice : public DeviceLayer {
+ public:
+  PathLossRadio* parent;
+  // these values are actually managed by the PathLossRadio
+  Population* cell; // which cell the device was last in (before motion)
+  int cell_loc; // where is the device in its cell's list
+  SECONDS last_tx; // a device cannot receive while it is transmitting
+  int received, lost_sinr; // packet counters, for dumps
+
+  PathLossDevice(PathLossRadio* parent, Device* container);
+  ~PathLossDevice();
+  void visualize();
+  void copy_state(DeviceLayer* src) {} // to be called during cloning
+  void dump_state(FILE* out, int verbosity);
+};
+
+#endif // __PATHLOSSRADIO__
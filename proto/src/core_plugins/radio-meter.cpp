@@ -0,0 +1,86 @@
+/* Instrumentation of the bytes a program puts on the air
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include "radio-meter.h"
+#include "radio.h"
+
+void ExportTally::add(Array<Data> const & data, vector<bool> const * changed) {
+  int size = RadioSim::sent_size(data,changed);
+  exports++; bytes += size; largest = max(largest,size);
+  if(slot_bytes.size() < data.size()) slot_bytes.resize(data.size(),0);
+  for(Size i = 0; i < data.size(); i++)
+    if(!changed) slot_bytes[i] += RadioSim::slot_size(data[i]);
+    else if((*changed)[i]) slot_bytes[i] += 1 + RadioSim::slot_size(data[i]);
+  if(changed) deltas++;
+}
+
+/*****************************************************************************
+ *  RADIO METER                                                              *
+ *****************************************************************************/
+RadioMeter::RadioMeter(Args* args, SpatialComputer* parent) : Layer(parent) {
+  args->undefault(&can_dump,"-Dmeter","-NDmeter");
+}
+
+RadioMeter::~RadioMeter() { report(); }
+
+void RadioMeter::add_device(Device* d) {
+  d->layers[id] = new DeviceRadioMeter(this,d);
+}
+
+bool RadioMeter::handle_key(KeyEvent* key) {
+  if(key->normal && !key->ctrl) {
+    switch(key->key) {
+    case 'M': report(); return true;
+    }
+  }
+  return false;
+}
+
+void RadioMeter::dump_header(FILE* out) {
+  if(can_dump) fprintf(out," \"EXPORTS/ROUND\" \"BYTES/ROUND\" \"MAX-EXPORT\"");
+}
+
+void RadioMeter::report() {
+  post("Radio meter: %ld exports, %ld bytes over %ld device rounds\n",
+       total.exports, total.bytes, total.rounds);
+  post("  per device round: %.2f exports, %.2f bytes; largest export %d bytes\n",
+       total.per_round(total.exports), total.per_round(total.bytes),
+       total.largest);
+  if(total.deltas)
+    post("  %ld of the exports were deltas\n", total.deltas);
+  if(total.slot_bytes.size()) {
+    post("  bytes per device round by slot:");
+    for(int i=0;i<total.slot_bytes.size();i++)
+      post(" %.2f",total.per_round(total.slot_bytes[i]));
+    post("\n");
+  }
+}
+
+/*****************************************************************************
+ *  PER-DEVICE METER                                                         *
+ *****************************************************************************/
+void DeviceRadioMeter::exported(Array<Data> const & data) {
+  vector<bool> const * changed = RadioSim::delta_of(container);
+  tally.add(data,changed); parent->total.add(data,changed);
+}
+
+void DeviceRadioMeter::dump_state(FILE* out, int verbosity) {
+  if(verbosity==0) {
+    fprintf(out," %.2f %.2f %d",tally.per_round(tally.exports),
+            tally.per_round(tally.bytes),tally.largest);
+  } else {
+    fprintf(out,"Exports/round = %.2f, Bytes/round = %.2f, Largest = %d\n",
+            tally.per_round(tally.exports),tally.per_round(tally.bytes),
+            tally.largest);
+    fprintf(out,"Bytes/round by slot:");
+    for(int i=0;i<tally.slot_bytes.size();i++)
+      fprintf(out," %.2f",tally.per_round(tally.slot_bytes[i]));
+    fprintf(out,"\n");
+  }
+}
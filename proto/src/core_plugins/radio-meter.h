@@ -0,0 +1,55 @@
+/* Instrumentation of the bytes a program puts on the air
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __RADIOMETER__
+#define __RADIOMETER__
+
+#include "proto_plugin.h"
+#include "spatialcomputer.h"
+#include <vector>
+using namespace std;
+
+// Traffic counters, kept both per device and in aggregate
+struct ExportTally {
+  long rounds, exports, deltas, bytes;
+  int largest;
+  vector<long> slot_bytes; // bytes contributed by each export slot
+  ExportTally() : rounds(0), exports(0), deltas(0), bytes(0), largest(0) {}
+  void add(Array<Data> const & data, vector<bool> const * changed);
+  flo per_round(long n) const { return rounds ? (flo)n/rounds : 0; }
+};
+
+// Sizes every export with the encoding of RadioSim::sent_size, whichever
+// radio carries it, so -delta-exports savings show up directly.  Dumps
+// (-Dmeter) give exports and bytes per round and the largest export for
+// each device; the totals are posted at exit.
+class RadioMeter : public Layer {
+ public:
+  ExportTally total;
+
+  RadioMeter(Args* args, SpatialComputer* parent);
+  ~RadioMeter();
+  void add_device(Device* d);
+  bool handle_key(KeyEvent* key);
+  void dump_header(FILE* out);
+  void report(); // post the aggregate counts
+};
+
+class DeviceRadioMeter : public DeviceLayer {
+  RadioMeter* parent;
+ public:
+  ExportTally tally;
+  DeviceRadioMeter(RadioMeter* parent, Device* d) : DeviceLayer(d)
+    { this->parent=parent; }
+  void update() { tally.rounds++; parent->total.rounds++; }
+  void exported(Array<Data> const & data);
+  void copy_state(DeviceLayer* src) {} // to be called during cloning
+  void dump_state(FILE* out, int verbosity); // print state to file
+};
+
+#endif // __RADIOMETER__
@@ -11,12 +11,55 @@ in the file LICENSE in the MIT Proto distribution's top directory.  */
 #include "wormhole-radio.h"
 #include "visualizer.h"
 
+#include <algorithm>
+#include <stdint.h>
+
+// Vose's alias method: O(1) draws of an index with probability
+// proportional to its weight
+class AliasSampler {
+  vector<flo> prob; vector<int> alias;
+ public:
+  AliasSampler(vector<flo> const & w) : prob(w.size()), alias(w.size(),0) {
+    int n = w.size(); flo sum = 0;
+    for(int i=0;i<n;i++) sum += w[i];
+    vector<int> small, large;
+    for(int i=0;i<n;i++) {
+      prob[i] = w[i]*n/sum;
+      (prob[i] < 1 ? small : large).push_back(i);
+    }
+    while(!small.empty() && !large.empty()) {
+      int s = small.back(), l = large.back(); small.pop_back();
+      alias[s] = l; prob[l] -= 1-prob[s];
+      if(prob[l] < 1) { large.pop_back(); small.push_back(l); }
+    }
+    for(size_t i=0;i<small.size();i++) prob[small[i]] = 1; // rounding leftovers
+    for(size_t i=0;i<large.size();i++) prob[large[i]] = 1;
+  }
+  int sample() const {
+    int i = rand() % prob.size();
+    return urnd(0,1) < prob[i] ? i : alias[i];
+  }
+};
+
 WormHoleRadio::WormHoleRadio(Args *args, SpatialComputer *p, int n) : RadioSim(args, p) {
   if(args->extract_switch("-wn")) {
     n_wormholes = (int)args->pop_number();
   } else {
     n_wormholes = 0;
   }
+  if(args->extract_switch("-wormhole-degree")) // mean degree, instead of -wn
+    n_wormholes = (int)(args->pop_number()*n/2);
+  endpoint_dist = UNIFORM;
+  if(args->extract_switch("-wormhole-dist")) {
+    string dist = args->pop_next();
+    if(dist == "powerlaw") endpoint_dist = POWER_LAW;
+    else if(dist != "uniform")
+      uerror("Unknown wormhole distribution: %s\n",dist.c_str());
+  }
+  exponent = (args->extract_switch("-wormhole-exponent")) ?
+    args->pop_number() : 2.5;
+  if(exponent <= 2) uerror("Wormhole exponent must be greater than 2\n");
+  args->undefault(&can_dump,"-Dradio","-NDradio");
 
   devices_left = n;
 
@@ -35,35 +78,59 @@ bool WormHoleRadio::handle_key(KeyEvent *key) {
 }
 
 void WormHoleRadio::add_device(Device* d) {
-  d->layers[id] = new WormHoleRadioDevice(this,d);
+  WormHoleRadioDevice* wd = new WormHoleRadioDevice(this,d);
+  wd->index = members.size(); members.push_back(d);
+  d->layers[id] = wd;
   if(--devices_left == 0) {attach_wormholes();} // connect when last device made
 }
 
-void WormHoleRadio::attach_wormholes() {
-  int w = 0;
-  while(w < n_wormholes) {
-    WormHoleRadioDevice *d1 = random_device();
-    WormHoleRadioDevice *d2 = random_device();
-
-    if(d1 != d2 && d1->nbrs.find(d2) == d1->nbrs.end()) {
-      connect_devices(d1, d2);
-      w++;
-    }
-  }
+void WormHoleRadio::dump_header(FILE* out) {
+  if(can_dump) fprintf(out," \"DEGREE\"");
 }
 
-WormHoleRadioDevice *WormHoleRadio::random_device() {
-  Device *d;
+// Draw endpoint pairs in bulk, drop self-links and duplicates by sorting,
+// and top up until the requested count is reached (or it stops growing).
+void WormHoleRadio::attach_wormholes() {
+  int n = members.size();
+  uint64_t most = (uint64_t)n*(n-1)/2;
+  if(n_wormholes < 0) n_wormholes = 0;
+  if((uint64_t)n_wormholes > most) {
+    post("WARNING: only %d wormholes fit between %d devices\n",(int)most,n);
+    n_wormholes = most;
+  }
+  size_t wanted = n_wormholes;
+  AliasSampler* weighted = NULL;
+  if(endpoint_dist == POWER_LAW) { // Chung-Lu weights, in random order
+    vector<flo> w(n);
+    for(int i=0;i<n;i++) w[i] = pow((flo)(i+1),-1/(exponent-1));
+    random_shuffle(w.begin(),w.end());
+    weighted = new AliasSampler(w);
+  }
+  vector<uint64_t> pairs; pairs.reserve(wanted);
+  size_t last;
   do {
-    int i = rand() % parent->devices.max_id();
-    d = (Device*)parent->devices.get(i);
-  } while(d == NULL);
-  return (WormHoleRadioDevice*)(d->layers[id]);
-}
-
-void WormHoleRadio::connect_devices(WormHoleRadioDevice *d1, WormHoleRadioDevice *d2) {
-  d1->nbrs.insert(d2);
-  d2->nbrs.insert(d1);
+    last = pairs.size();
+    while(pairs.size() < wanted) {
+      uint64_t a = weighted ? weighted->sample() : rand() % n;
+      uint64_t b = weighted ? weighted->sample() : rand() % n;
+      if(a == b) continue;
+      pairs.push_back(a < b ? (a<<32)|b : (b<<32)|a);
+    }
+    sort(pairs.begin(),pairs.end());
+    pairs.erase(unique(pairs.begin(),pairs.end()),pairs.end());
+  } while(pairs.size() < wanted && pairs.size() > last);
+  delete weighted;
+  // lay out the links of each index contiguously
+  link_start.assign(n+1,0);
+  for(size_t i=0;i<pairs.size();i++)
+    { link_start[(pairs[i]>>32)+1]++; link_start[(pairs[i]&0xffffffff)+1]++; }
+  for(int i=0;i<n;i++) link_start[i+1] += link_start[i];
+  link_end.resize(link_start[n]);
+  vector<int> fill(link_start.begin(),link_start.end()-1);
+  for(size_t i=0;i<pairs.size();i++) {
+    int a = pairs[i]>>32, b = pairs[i]&0xffffffff;
+    link_end[fill[a]++] = b; link_end[fill[b]++] = a;
+  }
 }
 
 Number WormHoleRadio::read_radio_range () {
@@ -77,23 +144,37 @@ int WormHoleRadio::radio_send_export (uint8_t version, Array<Data> const & data)
 
   int src_id = device->uid;
   const flo *me = device->body->position();
-  WormHoleRadioDevice *dev = (WormHoleRadioDevice*)device->layers[id];
-  for(typeof(dev->nbrs.begin()) it = dev->nbrs.begin();
-      it != dev->nbrs.end(); it++) {
-    WormHoleRadioDevice *o = *it;
-    if(try_rx()) {
-      const flo *them = o->container->body->position();
-
-      Neighbour & nbr = o->container->vm->hood[src_id];
-      nbr.x = me[0]-them[0];
-      nbr.y = me[1]-them[1];
-      nbr.z = me[2]-them[2];
-      nbr.imports = data;
-      nbr.data_age = 0;
+  vector<bool> const * changed = delta_of(device);
+  int i = ((WormHoleRadioDevice*)device->layers[id])->index;
+  int first = degree(i) ? link_start[i] : 0, last = first + degree(i);
+  for(int l = first; l < last; l++) {
+    Device* o = members[link_end[l]];
+    if(o && try_rx()) {
+      const flo *them = o->body->position();
+      Neighbour* nbr = receive_export(o->vm,src_id,version,data,changed);
+      if(!nbr) continue; // delta without a fresh base
+      nbr->x = me[0]-them[0];
+      nbr->y = me[1]-them[1];
+      nbr->z = me[2]-them[2];
     }
   }
+  return 1;
+}
 
-  hardware->set_vm_context(dev->container);
+bool WormHoleRadio::list_receivers(vector<Reception>* out) {
+  const flo *me = device->body->position();
+  int i = ((WormHoleRadioDevice*)device->layers[id])->index;
+  int first = degree(i) ? link_start[i] : 0, last = first + degree(i);
+  for(int l = first; l < last; l++) {
+    Device* o = members[link_end[l]];
+    if(o) {
+      const flo *them = o->body->position();
+      Reception r; r.rx = o;
+      for(int j=0;j<3;j++) r.dp[j] = me[j]-them[j];
+      out->push_back(r);
+    }
+  }
+  return true;
 }
 
 int WormHoleRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
@@ -113,6 +194,7 @@ int WormHoleRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
   }
 
   hardware->set_vm_context(dev->container);*/
+  return 0;
 }
 
 int WormHoleRadio::radio_send_digest (uint8_t version, uint16_t script_len,
@@ -132,15 +214,24 @@ int WormHoleRadio::radio_send_digest (uint8_t version, uint16_t script_len,
   }
 
   hardware->set_vm_context(dev->container);-*/
+  return 0;
 }
 
 WormHoleRadioDevice::WormHoleRadioDevice(WormHoleRadio *parent, Device *container)
   : DeviceLayer(container) {
-  this->parent = parent;
+  this->parent = parent; index = -1;
 }
 
 WormHoleRadioDevice::~WormHoleRadioDevice() {
-  
+  parent->members[index] = NULL; // links to a lost device go silent
+}
+
+void WormHoleRadioDevice::dump_state(FILE* fp, int verbosity) {
+  if(verbosity==0) {
+    fprintf(fp," %d",parent->degree(index));
+  } else {
+    fprintf(fp,"Wormholes = %d\n",parent->degree(index));
+  }
 }
 
 void WormHoleRadioDevice::visualize() {
@@ -169,9 +260,11 @@ void WormHoleRadioDevice::visualize() {
     // do the actual draw
     glBegin(GL_LINES);
     const flo *me = container->body->position();
-    for(typeof(nbrs.begin()) it = nbrs.begin(); it != nbrs.end(); it++) {
-      if((local_sharp || (*it)->container->uid > container->uid)) {
-        const flo *them = (*it)->container->body->position();
+    int first = parent->degree(index) ? parent->link_start[index] : 0;
+    for(int l = first; l < first + parent->degree(index); l++) {
+      Device* o = parent->members[parent->link_end[l]];
+      if(o && (local_sharp || o->uid > container->uid)) {
+        const flo *them = o->body->position();
         glVertex3f(0,0,0);
         glVertex3f(them[0]-me[0], them[1]-me[1], them[2]-me[2]);
       }
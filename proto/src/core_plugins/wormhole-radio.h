@@ -13,39 +13,54 @@ in the file LICENSE in the MIT Proto distribution's top directory.  */
 #include "proto_plugin.h"
 #include "spatialcomputer.h"
 #include "radio.h"
-#include <set>
+#include <vector>
 using namespace std;
 
 class WormHoleRadioDevice;
 
+// Links are drawn all at once when the last initial device is made.
+// Endpoints are picked either uniformly (small-world shortcuts over a
+// local radio) or with power-law weights (-wormhole-dist powerlaw), so
+// that degrees follow a power-law tail with -wormhole-exponent.  They
+// are kept in compressed sparse row form over device indices.
 class WormHoleRadio : public RadioSim {
 public:
+  enum EndpointDist { UNIFORM, POWER_LAW };
   int n_wormholes;
   int devices_left;
+  EndpointDist endpoint_dist;
+  flo exponent;             // power-law degree exponent, must exceed 2
 
   WormHoleRadio(Args *args, SpatialComputer *parent, int n);
   ~WormHoleRadio();
 
   bool handle_key(KeyEvent* key);
   void add_device(Device* d);
+  void dump_header(FILE* out);
 
   Number read_radio_range ();
   int radio_send_export (uint8_t version, Array<Data> const &);
-  int radio_send_script_pkt (uint8_t version, uint16_t n, 
+  int radio_send_script_pkt (uint8_t version, uint16_t n,
                              uint8_t pkt_num, uint8_t *script);
-  int radio_send_digest (uint8_t version, uint16_t script_len, 
+  int radio_send_digest (uint8_t version, uint16_t script_len,
                          uint8_t *digest);
+  bool list_receivers(vector<Reception>* out);
 
 private:
-  WormHoleRadioDevice *random_device();
+  vector<Device*> members;  // by index; NULL once a device is gone
+  vector<int> link_start;   // links of index i are link_end[start[i]..start[i+1])
+  vector<int> link_end;     // index at the far end of each link
+
   void attach_wormholes();
-  void connect_devices(WormHoleRadioDevice *, WormHoleRadioDevice *);
+  int degree(int i) const
+    { return i+1 < link_start.size() ? link_start[i+1]-link_start[i] : 0; }
+
+  friend class WormHoleRadioDevice;
 };
 
 class WormHoleRadioDevice : public DeviceLayer {
   WormHoleRadio *parent;
-
-  set<WormHoleRadioDevice*> nbrs;
+  int index; // position in the parent's link table
 
   friend class WormHoleRadio;
 
@@ -54,6 +69,7 @@ public:
   ~WormHoleRadioDevice();
 
   void visualize();
+  void dump_state(FILE* out, int verbosity);
 
   void copy_state(DeviceLayer* src) {}
 };
@@ -0,0 +1,156 @@
+/* Offline replay of recorded VM traces
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+// proto-replay reruns a trace written by "proto -record-trace FILE",
+// giving each VM the neighbourhoods, sensor values and platform op results
+// it saw in the simulator.  No radio, physics or display is involved, so
+// the time it reports is the time spent in the VM alone.
+
+#include "config.h"
+#include <iostream>
+#include <map>
+#include "trace.h"
+#include "utils.h"
+
+/*****************************************************************************
+ *  PLATFORM CALLOUTS                                                        *
+ *****************************************************************************/
+// Sensors and platform ops give back what was recorded, in order;
+// actuators have nothing to act on.
+static TraceEvent const * event = NULL; // the event being replayed
+static Machine* current = NULL;         // and the machine replaying it
+static Size next_reading = 0;
+static long starved = 0;                // readings asked for but not recorded
+
+static TraceReading const * take_reading() {
+  if(!event || next_reading >= event->readings.size()) { starved++; return NULL; }
+  return &event->readings[next_reading++];
+}
+
+static Number recorded_number() {
+  TraceReading const * r = take_reading();
+  return (r && r->values.size()==1) ? r->values[0].asNumber() : Number(0);
+}
+
+Number read_radio_range() { return recorded_number(); }
+Number read_bearing() { return recorded_number(); }
+Number read_speed() { return recorded_number(); }
+void flex(Number val) {}
+void mov(Tuple val) {}
+void set_probe(Data d, Int8 p) {}
+
+void platform_operation(Int8 op) {
+  TraceReading const * r = take_reading();
+  if(!r) return;
+  current->stack.pop(r->pops);
+  for(Size i = 0; i < r->values.size(); i++) current->stack.push(r->values[i]);
+}
+
+/*****************************************************************************
+ *  REPLAY                                                                   *
+ *****************************************************************************/
+// Make the hood look as the radio left it, reusing entries where the
+// order agrees, which it does unless neighbours came or went.
+static void restore_hood(Machine* vm, vector<TraceNeighbour> const & hood) {
+  NeighbourHood::iterator i = vm->hood.begin(); i++; // keep self
+  for(Size k = 0; k < hood.size(); k++) {
+    TraceNeighbour const & n = hood[k];
+    while(i != vm->hood.end() && i->id != n.id) i = vm->hood.remove(i);
+    if(i == vm->hood.end()) i = vm->hood.add(n.id);
+    i->heard_round = n.heard_round; i->heard_time = n.heard_time;
+    i->x = n.x; i->y = n.y; i->z = n.z; i->lag = n.lag;
+    for(Size j = 0; j < i->imports.size() && j < n.imports.size(); j++)
+      i->imports[j] = n.imports[j];
+    i++;
+  }
+  while(i != vm->hood.end()) i = vm->hood.remove(i);
+}
+
+struct ReplayStats { long loads, computes, steps; };
+
+static ReplayStats replay(TraceReader & trace, map<MachineId,Machine*> & vms) {
+  ReplayStats stats = {0,0,0};
+  starved = 0;
+  for(Size k = 0; k < trace.events.size(); k++) {
+    event = &trace.events[k]; next_reading = 0;
+    Machine*& vm = vms[event->uid];
+    if(!vm) {
+      vm = new Machine();
+      vm->hood_timeout = trace.hood_timeout;
+      vm->hood_timeout_secs = trace.hood_timeout_secs;
+    }
+    current = vm;
+    if(event->type==TRACE_LOAD) {
+      vm->id = event->uid;
+      vm->install(Script(trace.scripts[event->script],
+                         trace.script_sizes[event->script]));
+      stats.loads++;
+    } else {
+      if(vm->hood.empty()) continue; // nothing loaded yet
+      restore_hood(vm,event->hood);
+      vm->rounds = event->rounds;
+      vm->thisMachine().heard_round = vm->rounds;
+      vm->thisMachine().heard_time = event->time;
+      vm->run(event->time);
+      stats.computes++;
+    }
+    for(Size runs = 1; ; runs++) {
+      while(!vm->finished()) { vm->step(); stats.steps++; }
+      // as in the simulator, every thread due at a compute runs, each once
+      if(event->type==TRACE_LOAD || runs >= vm->threads.size() ||
+         !vm->due(event->time)) break;
+      vm->run(event->time);
+    }
+    if(next_reading < event->readings.size()) starved++;
+  }
+  event = NULL; current = NULL;
+  return stats;
+}
+
+static void clear(map<MachineId,Machine*> & vms) {
+  for(map<MachineId,Machine*>::iterator i=vms.begin(); i!=vms.end(); i++)
+    delete i->second;
+  vms.clear();
+}
+
+int main(int argc, char *argv[]) {
+  Args *args = new Args(argc,argv);
+  int repeat = args->extract_switch("-repeat") ? max(1,args->pop_int()) : 1;
+  bool verbose = args->extract_switch("-v");
+  if(args->argc < 2)
+    uerror("Usage: proto-replay [-repeat N] [-v] TRACE-FILE");
+  TraceReader trace(args->argv[args->argc-1]);
+
+  // report the best of the repetitions, each starting from fresh VMs
+  map<MachineId,Machine*> vms;
+  ReplayStats stats; double best = -1;
+  for(int r = 0; r < repeat; r++) {
+    clear(vms);
+    double start = get_real_secs();
+    stats = replay(trace,vms);
+    double secs = get_real_secs() - start;
+    if(best < 0 || secs < best) best = secs;
+  }
+  if(starved)
+    post("Warning: %ld events did not use exactly the recorded readings;\n"
+         "  the replay has diverged from the recording\n", starved);
+  post("%ld devices, %ld loads, %ld computes, %ld instructions\n",
+       (long)vms.size(), stats.loads, stats.computes, stats.steps);
+  post("best of %d: %.4f s, %.0f computes/s, %.0f instructions/s\n", repeat,
+       best, best>0 ? stats.computes/best : 0, best>0 ? stats.steps/best : 0);
+
+  if(verbose) { // final outputs, for checking against a simulator dump
+    for(map<MachineId,Machine*>::iterator i=vms.begin(); i!=vms.end(); i++) {
+      cout << i->first << " ";
+      if(i->second->threads.size()) i->second->print_data(i->second->threads[0].result);
+      cout << endl;
+    }
+  }
+  clear(vms);
+  return 0;
+}
@@ -49,8 +49,9 @@ DeviceTimer* FixedIntervalTime::next_timer(SECONDS* start_lag) {
 }
 
 Number FixedIntervalTime::set_dt (Number dt) {
-	//TODO/Delft: Let the VM scheduler handle this instead.
-  ((FixedTimer*)device->timer)->set_internal_dt(dt);
+  // The VM scheduler keeps the period SET_DT gives a thread (see
+  // Thread::due).  The device keeps its own ticks, so that its other
+  // threads with shorter periods still run at every one.
   return dt;
 }
 
@@ -38,6 +38,7 @@ public:
   DeviceTimer* next_timer(SECONDS* start_lag);
 
   SECONDS cycle_time() { return dt; }
+  bool is_synchronous() { return sync; }
   Number set_dt (Number dt);
 
 };
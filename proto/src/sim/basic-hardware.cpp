@@ -125,16 +125,17 @@ void DebugLayer::hsv_op(Machine* machine) {
   machine->nextInt8();
   Tuple hsv = machine->stack.popTuple();
   flo r, g, b;
-  my_hsv_to_rgb(hsv[0].asNumber(), hsv[1].asNumber(), hsv[2].asNumber(), &r, &g, &b);
+  my_hsv_to_rgb(Number_toDouble(hsv[0].asNumber()), Number_toDouble(hsv[1].asNumber()),
+                Number_toDouble(hsv[2].asNumber()), &r, &g, &b);
   Tuple rgb(3);
-  rgb.push(r);
-  rgb.push(g);
-  rgb.push(b);
+  rgb.push(Number(r));
+  rgb.push(Number(g));
+  rgb.push(Number(b));
   machine->stack.push(rgb);
 }
 
 void DebugLayer::sense_op(Machine* machine) {
-  machine->stack.push(read_sensor((uint8_t) machine->stack.popNumber()));
+  machine->stack.push(read_sensor((uint8_t) Number_toDouble(machine->stack.popNumber())));
 }  
 
 bool DebugLayer::handle_key(KeyEvent* key) {
@@ -179,11 +180,11 @@ void DebugLayer::set_g_led (Number val)
 void DebugLayer::set_b_led (Number val)
 { ((DebugDevice*)device->layers[id])->actuators[B_LED] = val; }
 Number DebugLayer::read_sensor (uint8_t n)
-{ return (n<N_SENSORS) ? ((DebugDevice*)device->layers[id])->sensors[USER_A+n-1] : NAN;}
+{ return (n<N_SENSORS) ? ((DebugDevice*)device->layers[id])->sensors[USER_A+n-1] : Number(NAN);}
 
 // per-device interface, used primarily for visualization
 DebugDevice::DebugDevice(DebugLayer* parent, Device* d) : DeviceLayer(d) {
-  for(int i=0;i<MAX_PROBES;i++) probes[i] = 0; // probes start clear
+  for(int i=0;i<MAX_PROBES;i++) probes[i] = Number(0); // probes start clear
   for(int i=0;i<N_ACTUATORS;i++) actuators[i] = 0; // actuators start clear
   for(int i=0;i<N_SENSORS;i++) sensors[i] = 0; // sensors start clear
   this->parent = parent;
@@ -194,19 +195,19 @@ void DebugDevice::dump_state(FILE* out, int verbosity) {
   if(verbosity==0) {
     uint32_t dumpmask = parent->dumpmask; // shorten the name
     // there was another sensor here, but it's been removed
-    if(dumpmask & 0x02) fprintf(out," %.2f",sensors[USER_A]);
-    if(dumpmask & 0x04) fprintf(out," %.2f",sensors[USER_B]);
-    if(dumpmask & 0x08) fprintf(out," %.2f",sensors[USER_C]);
-    if(dumpmask & 0x10) fprintf(out," %.2f",sensors[USER_D]);
-    if(dumpmask & 0x20) fprintf(out," %.3f",actuators[R_LED]);
-    if(dumpmask & 0x40) fprintf(out," %.3f",actuators[G_LED]);
-    if(dumpmask & 0x80) fprintf(out," %.3f",actuators[B_LED]);
+    if(dumpmask & 0x02) fprintf(out," %.2f",Number_toDouble(sensors[USER_A]));
+    if(dumpmask & 0x04) fprintf(out," %.2f",Number_toDouble(sensors[USER_B]));
+    if(dumpmask & 0x08) fprintf(out," %.2f",Number_toDouble(sensors[USER_C]));
+    if(dumpmask & 0x10) fprintf(out," %.2f",Number_toDouble(sensors[USER_D]));
+    if(dumpmask & 0x20) fprintf(out," %.3f",Number_toDouble(actuators[R_LED]));
+    if(dumpmask & 0x40) fprintf(out," %.3f",Number_toDouble(actuators[G_LED]));
+    if(dumpmask & 0x80) fprintf(out," %.3f",Number_toDouble(actuators[B_LED]));
     // probes can't be output gracefully since we don't know what they contain
   } else {
     fprintf(out,"Sensors: User-1=%.2f User-2=%.2f User-3=%.2f User-4=%.2f\n",
-            sensors[USER_A], sensors[USER_B], sensors[USER_C], sensors[USER_D]);
-    fprintf(out,"LEDs: R=%.3f G=%.3f B=%.3f\n", actuators[R_LED],
-            actuators[G_LED], actuators[B_LED]);
+            Number_toDouble(sensors[USER_A]), Number_toDouble(sensors[USER_B]), Number_toDouble(sensors[USER_C]), Number_toDouble(sensors[USER_D]));
+    fprintf(out,"LEDs: R=%.3f G=%.3f B=%.3f\n", Number_toDouble(actuators[R_LED]),
+            Number_toDouble(actuators[G_LED]), Number_toDouble(actuators[B_LED]));
     fprintf(out,"Probes:");
     char buf[1000];
     for(int i=0;i<MAX_PROBES;i++) {
@@ -220,20 +221,20 @@ bool DebugDevice::handle_key(KeyEvent* key) {
   if(key->normal && !key->ctrl) {
     switch(key->key) {
     case 't': 
-      sensors[USER_A] = sensors[USER_A] ? 0:1; return true;
+      sensors[USER_A] = sensors[USER_A] != 0 ? 0:1; return true;
     case 'y': 
-      sensors[USER_B] = sensors[USER_B] ? 0:1; return true;
+      sensors[USER_B] = sensors[USER_B] != 0 ? 0:1; return true;
     case 'u': 
-      sensors[USER_C] = sensors[USER_C] ? 0:1; return true;
+      sensors[USER_C] = sensors[USER_C] != 0 ? 0:1; return true;
     case 'o':
-      sensors[USER_D] = sensors[USER_D] ? 0:1; return true;
+      sensors[USER_D] = sensors[USER_D] != 0 ? 0:1; return true;
     }
   }
   return false;
 }
 
 void DebugDevice::preupdate() {
-  for(int i=0;i<MAX_PROBES;i++) { probes[i] = 0; }
+  for(int i=0;i<MAX_PROBES;i++) { probes[i] = Number(0); }
   for(int i=0;i<N_ACTUATORS;i++) { actuators[i] = 0; }
 }
 
@@ -255,8 +256,8 @@ void DebugDevice::visualize() {
   if (parent->is_show_leds) {
     static Color* led_color[3] = 
       {DebugLayer::RED_LED, DebugLayer::GREEN_LED, DebugLayer::BLUE_LED};
-    flo led[3] = { actuators[R_LED], actuators[G_LED],
-		   actuators[B_LED] };
+    flo led[3] = { Number_toDouble(actuators[R_LED]), Number_toDouble(actuators[G_LED]),
+		   Number_toDouble(actuators[B_LED]) };
     glPushMatrix();
     if (parent->is_led_rgb) {
       if (led[0] || led[1] || led[2]) {
@@ -329,13 +330,13 @@ Tuple PerfectLocalizer::read_coord_sensor() {
   PerfectLocalizerDevice* d = (PerfectLocalizerDevice*)device->layers[id];
   if(!d->coord_sense.isSet()) {
     Tuple c(3);
-    c.push(0);
-    c.push(0);
-    c.push(0);
+    c.push(Number(0));
+    c.push(Number(0));
+    c.push(Number(0));
     d->coord_sense = c;
   }
   const METERS* p = device->body->position();
-  for(int i=0;i<3;i++) d->coord_sense.asTuple()[i] = p[i];
+  for(int i=0;i<3;i++) d->coord_sense.asTuple()[i] = Number(p[i]);
   return d->coord_sense.asTuple();
 }
 
@@ -0,0 +1,145 @@
+/* Static decoding of DelftProto bytecode
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "bytecode.h"
+
+namespace {
+  // Opcodes not listed here take no operands and always continue with the
+  // next instruction.  Keep this in step with vm/instructions/*.cpp.
+  struct OperandSpec { const char* name; const char* operands;
+                       bool is_flow, skips; };
+  const OperandSpec specs[] = {
+    {"DEF_VM","bbwbwb",true,false},   {"DEF_VM_EX","iiiiiii",true,false},
+    {"EXIT","",true,false},           {"RET","",true,false},
+    {"ALL","i",false,false},          {"VMUX","b",false,false},
+    {"IF","i",true,true},             {"IF16","w",true,true},
+    {"JMP","i",true,true},            {"JMP16","w",true,true},
+    {"FUNCALL","i",true,false},       {"FUNCALL_N","",true,false},
+    {"REF","i",false,false},          {"LET","i",false,false},
+    {"POP_LET","i",false,false},      {"GLO_REF","i",false,false},
+    {"GLO_REF16","w",false,false},
+    {"DEF_FUN","i",true,true},        {"DEF_FUN16","w",true,true},
+    {"DEF_FUN_N","",true,true},       {"DEF_NUM_VEC","i",false,false},
+    {"DEF_TUP","i",false,false},      {"DEF_VEC","i",false,false},
+    {"ACTIVATE","i",false,false},     {"DEACTIVATE","i",false,false},
+    {"TRIGGER","i",false,false},      {"RESULT","i",false,false},
+    {"LIT","i",false,false},          {"LIT8","b",false,false},
+    {"LIT16","w",false,false},        {"LIT_FLO","f",false,false},
+    {"TUP","bb",false,false},         {"FAB_TUP","i",false,false},
+    {"FAB_VEC","i",false,false},      {"FAB_NUM_VEC","i",false,false},
+    {"VADD","b",false,false},         {"VSUB","b",false,false},
+    {"VMUL","b",false,false},         {"VSLICE","b",false,false},
+    {"APPLY","",true,false},          {"TUP_MAP","",true,false},
+    {"MAP","b",true,false},           {"FOLD","",true,false},
+    {"VFOLD","b",true,false},
+    {"INIT_FEEDBACK","i",true,false}, {"SET_FEEDBACK","i",false,false},
+    {"FEEDBACK","i",false,false},
+    {"FOLD_HOOD","i",true,false},     {"VFOLD_HOOD","bi",true,false},
+    {"FOLD_HOOD_PLUS","i",true,false},{"VFOLD_HOOD_PLUS","bi",true,false},
+    {"NBR_VEC","b",false,false},
+  };
+
+  OpcodeInfo table[256];
+  char names[256][32], keys[256][32];
+  bool table_ready = false;
+
+  void describe(int opcode, const char* name, int n) {
+    OpcodeInfo & op = table[opcode];
+    if(n<0) snprintf(names[opcode],sizeof(names[opcode]),"%s",name);
+    else snprintf(names[opcode],sizeof(names[opcode]),"%s_N<%d>",name,n);
+    snprintf(keys[opcode],sizeof(keys[opcode]),n<0 ? "%s" : "%s_N",name);
+    op.name = names[opcode]; op.key = keys[opcode];
+    op.operands = ""; op.is_flow = op.skips = false; op.n = n;
+    for(int i=0;i<sizeof(specs)/sizeof(specs[0]);i++) {
+      if(!strcmp(specs[i].name,op.key)) {
+        op.operands = specs[i].operands;
+        op.is_flow = specs[i].is_flow; op.skips = specs[i].skips;
+      }
+    }
+  }
+
+  // same numbering as the instructions table in instructions.cpp
+  void build_table() {
+    int opcode = 0;
+#	define INSTRUCTION(name) describe(opcode++,#name,-1);
+#	define INSTRUCTION_N(name,n) describe(opcode++,#name,n);
+#	include <delftproto.instructions>
+#	undef INSTRUCTION
+#	undef INSTRUCTION_N
+    table_ready = true;
+  }
+
+  // read one operand at p, leaving its value in value; false if past end
+  bool read_operand(char kind, Int8 const * s, Size len, Size & p, Int & value) {
+    switch(kind) {
+    case 'b': if(p+1>len) return false; value = s[p++]; return true;
+    case 'w': if(p+2>len) return false;
+      value = (s[p]<<8) | s[p+1]; p+=2; return true;
+    case 'f': if(p+4>len) return false; p+=4; return true;
+    case 'i':
+      value = 0;
+      while(true) { // as Machine::nextInt
+        if(p>=len) return false;
+        Int8 next = s[p++];
+        value |= next & 0x7F;
+        if(next & 0x80) value <<= 7; else return true;
+      }
+    }
+    return false;
+  }
+
+  bool by_offset(DecodedInstruction const & a, DecodedInstruction const & b) {
+    return a.offset < b.offset;
+  }
+}
+
+OpcodeInfo const & opcode_info(Int8 opcode) {
+  if(!table_ready) build_table();
+  return table[opcode];
+}
+
+bool read_int(Int8 const * s, Size len, Size & p, Int & value) {
+  return read_operand('i',s,len,p,value);
+}
+
+bool decode_at(Int8 const * s, Size len, Size at, DecodedInstruction & d) {
+  if(at >= len) return false;
+  OpcodeInfo const & op = opcode_info(s[at]);
+  if(!op.name) return false; // a platform op: its length is unknown
+  d.offset = at; d.opcode = s[at]; d.operand = 0;
+  d.has_target = false; d.target = 0;
+  Size p = at+1;
+  for(const char* o = op.operands; *o; o++)
+    if(!read_operand(*o,s,len,p,d.operand)) return false;
+  d.length = p-at;
+  if(op.skips) {
+    d.has_target = true; d.target = p + (op.n<0 ? d.operand : op.n);
+  }
+  return true;
+}
+
+std::vector<DecodedInstruction> decode_script(Int8 const * s, Size len) {
+  std::vector<DecodedInstruction> out;
+  std::vector<bool> seen(len,false);
+  std::vector<Size> starts(1,0);
+  while(!starts.empty()) {
+    Size at = starts.back(); starts.pop_back();
+    DecodedInstruction d;
+    while(at < len && !seen[at] && decode_at(s,len,at,d)) {
+      if(d.has_target && d.target <= len) starts.push_back(d.target);
+      seen[at] = true; out.push_back(d);
+      at += d.length;
+    }
+  }
+  std::sort(out.begin(),out.end(),by_offset);
+  return out;
+}
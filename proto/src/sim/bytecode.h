@@ -0,0 +1,55 @@
+/* Static decoding of DelftProto bytecode
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __BYTECODE__
+#define __BYTECODE__
+
+#include <vector>
+#include <machine.hpp>
+
+// What the simulator's instruction set looks like from outside the VM:
+// the C++ name of each opcode's implementation, its operands, and whether
+// it can move the instruction pointer anywhere but the next instruction.
+// Operands are one letter each: 'i' a variable-length Int, 'b' a byte,
+// 'w' a 16-bit big-endian Int16 and 'f' a 4-byte float.
+struct OpcodeInfo {
+  const char* name;     // e.g. "ADD" or "LIT_N<2>"; NULL for platform ops
+  const char* key;      // the name without its template argument: "LIT_N"
+  const char* operands;
+  bool is_flow;         // jumps, calls, returns or defines a function
+  bool skips;           // IF, JMP, DEF_FUN: may skip ahead by its last
+                        // operand (or by n) bytes
+  int n;                // template argument of the _N forms, else -1
+};
+
+OpcodeInfo const & opcode_info(Int8 opcode);
+
+// One instruction of a script, as found by decode_script
+struct DecodedInstruction {
+  Size offset, length;
+  Int8 opcode;
+  Int operand;          // the value of its last operand, if any
+  Size target;          // IF/JMP destination, or the end of a DEF_FUN body
+  bool has_target;
+};
+
+// Read a variable-length Int at offset p, as Machine::nextInt does, moving
+// p past it; false if it runs past the end of the script.
+bool read_int(Int8 const * script, Size len, Size & p, Int & value);
+
+// Decode the instruction at offset at; false if its opcode has no known
+// encoding or it runs past the end of the script.
+bool decode_at(Int8 const * script, Size len, Size at, DecodedInstruction & d);
+
+// Decode a script from its start and from every branch target and
+// function end found on the way.  Decoding along a path stops at an opcode
+// with no known encoding (a platform op), since its length is unknown;
+// such code is left to the interpreter.  The result is sorted by offset.
+std::vector<DecodedInstruction> decode_script(Int8 const * script, Size len);
+
+#endif // __BYTECODE__
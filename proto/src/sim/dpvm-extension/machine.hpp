@@ -3,7 +3,96 @@ void platform_operation(Int8); // This will be called for any unknown opcode.
 
 class SimMachine : public Machine {
 	
+	public:
+		Counter rounds; // The number of computes started so far.
+		
+		/// Neighbours not heard from for more than this many rounds are expired;
+		/// if hood_timeout_secs is positive, it is measured in seconds instead.
+		Counter hood_timeout;
+		Time hood_timeout_secs;
+		
+		SimMachine() : rounds(0), hood_timeout(2), hood_timeout_secs(0) {}
+		
+		/// Rounds since a neighbour's data last arrived.
+		inline Counter age(Neighbour const & n) const {
+			return rounds - n.heard_round;
+		}
+		
+		inline bool expired(Neighbour const & n) const {
+			return expired(n, start_time);
+		}
+		
+		/// Whether a neighbour will have expired for a run started at the given time.
+		inline bool expired(Neighbour const & n, Time start) const {
+			if (hood_timeout_secs > 0) return start - n.heard_time > hood_timeout_secs;
+			return age(n) > hood_timeout;
+		}
+		
+		/// The number of neighbours (including this machine) that have not expired.
+		inline Size fresh_hood_size() {
+			Size n = 0;
+			for(NeighbourHood::iterator i = hood.begin(); i != hood.end(); i++) if (!expired(*i)) n++;
+			return n;
+		}
+		
+		/// Install the script another machine has installed, copying what its installation left instead of running it again.
+		/**
+		 * Only for scripts whose installation does the same on every machine.
+		 * The threads are copied; the state and the hood start empty, as after an installation.
+		 */
+		inline void install_as(SimMachine const & installed) {
+			script = installed.script;
+			instruction_pointer = installed.instruction_pointer;
+			stack.reset(capacity(installed.stack));
+			environment.reset(capacity(installed.environment));
+			globals.reset(capacity(installed.globals));
+			for (Index i = 0; i < installed.globals.size(); i++) globals.push(installed.globals[i]);
+			threads = installed.threads;
+			resetState(installed.state.size());
+			firstFeedbackUpdate.reset(capacity(installed.firstFeedbackUpdate));
+			hood.reset(installed.thisMachine().imports.size());
+			hood.add(id);
+			callbacks.reset(capacity(installed.callbacks));
+			current_thread = installed.current_thread;
+		}
+		
+		/// Copy the state variables of another machine running the same script, as when the device it runs on is cloned.
+		inline void copy_state(SimMachine const & other) {
+			state = other.state;
+			state_threads = other.state_threads;
+		}
+		
+		/// The depth of the callback stack: one for the run, and one more for each function called and not yet returned.
+		inline Size call_depth() const {
+			return callbacks.size();
+		}
+		
+		/// The offset of the next instruction in the script.
+		inline Size script_offset() const {
+			return (Int8 const *)instruction_pointer - (Int8 const *)script;
+		}
+		
+		/// Make room on each stack for the given number of elements, so that a
+		/// script verified to stay within them never reallocates as it runs.
+		inline void reserve(Size stack_size, Size environment_size, Size callbacks_size, Size feedback_size) {
+			ensure(stack, stack_size);
+			ensure(environment, environment_size);
+			ensure(callbacks, callbacks_size);
+			ensure(firstFeedbackUpdate, feedback_size);
+		}
+		
 	protected:
+		template<typename S>
+		static inline Size capacity(S const & s) {
+			return s.size() + s.free();
+		}
+		
+		template<typename S>
+		static inline void ensure(S & s, Size wanted) {
+			Size have = capacity(s);
+			if (have < wanted) s.grow(wanted - have);
+		}
+		
 		void execute_unknown(Int8 opcode) {
 			platform_operation(opcode);
 		}
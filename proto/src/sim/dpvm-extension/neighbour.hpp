@@ -1,13 +1,15 @@
 
 class SimNeighbour : public Neighbour {
 	public:
-		Counter data_age; // The number of rounds executed since the last update of the data of this neighbour.
+		Counter heard_round; // The round of the receiving machine in which this neighbour's data last arrived.
+		Time heard_time; // The simulated time at which it arrived.
+		Int8 export_seq; // The sequence number of the export it came in (see RadioSim::receive_export).
 		Number x, y, z;
 		Number lag;
 		
 		bool in_range;
 		
-		SimNeighbour(MachineId const & id, Size imports) : Neighbour(id, imports) {x = 0; y = 0; z = 0; lag = 0; in_range = false;}
+		SimNeighbour(MachineId const & id, Size imports) : Neighbour(id, imports) {x = 0; y = 0; z = 0; lag = 0; in_range = false; heard_round = 0; heard_time = 0; export_seq = 0;}
 };
 
 #undef Neighbour
@@ -39,7 +39,7 @@ namespace Instructions {
 	}
 	
 	void PROBE(Machine & machine){
-		Int8 i = machine.stack.pop().asNumber();
+		Int8 i = Int8(Number_toDouble(machine.stack.pop().asNumber()));
 		set_probe(machine.stack.peek(), i);
 	}
 	
@@ -48,15 +48,15 @@ namespace Instructions {
 	}
 	
 	void NBR_RANGE(Machine & machine){
-		float x = machine.currentNeighbour().x;
-		float y = machine.currentNeighbour().y;
-		float z = machine.currentNeighbour().z;
+		float x = Number_toDouble(machine.currentNeighbour().x);
+		float y = Number_toDouble(machine.currentNeighbour().y);
+		float z = Number_toDouble(machine.currentNeighbour().z);
 		machine.stack.push(sqrt(x*x + y*y + z*z));
 	}
 	
 	void NBR_BEARING(Machine & machine){
-		float x = machine.currentNeighbour().x;
-		float y = machine.currentNeighbour().y;
+		float x = Number_toDouble(machine.currentNeighbour().x);
+		float y = Number_toDouble(machine.currentNeighbour().y);
 		machine.stack.push(atan2(y,x));
 	}
 	
@@ -75,11 +75,11 @@ namespace Instructions {
 		}
 		
 		Number machine_area(Machine & machine) {
-			return machine_disc_area(machine) / static_cast<Number>(machine.hood.size());
+			return machine_disc_area(machine) / static_cast<Number>(machine.fresh_hood_size());
 		}
 		
 		Number machine_density(Machine & machine) {
-			return static_cast<Number>(machine.hood.size()) / machine_disc_area(machine);
+			return static_cast<Number>(machine.fresh_hood_size()) / machine_disc_area(machine);
 		}
 	}
 	
@@ -0,0 +1,96 @@
+/* Ahead-of-time translation of scripts to native code
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include "native.h"
+#include "bytecode.h"
+
+// The generated code includes the instruction implementations themselves,
+// as vm/instructions.cpp does, so the compiler can inline them.  The sim
+// directory comes first, for the simulator's Machine and platform ops.
+static const char* instruction_files[] = {
+  "flow", "environment", "globals", "threads", "literals", "math", "tuple",
+  "specialform", "feedback", "hood", "platform"
+};
+
+NativeCompiler::NativeCompiler(Args* args) {
+  cxx = args->extract_switch("-native-cxx") ? args->pop_next() : NATIVE_CXX;
+  flags = args->extract_switch("-native-flags") ? args->pop_next() :
+    "-O2 -std=gnu++98 -fpermissive -w";
+  keep = args->extract_switch("-native-dir");
+  if(keep) {
+    dir = args->pop_next();
+  } else {
+    char tmp[] = "/tmp/proto-native-XXXXXX";
+    if(mkdtemp(tmp)) dir = tmp;
+    else uerror("-native: couldn't make a directory for its code");
+  }
+  count = 0;
+}
+
+NativeCompiler::~NativeCompiler() { if(!keep) rmdir(dir.c_str()); }
+
+void NativeCompiler::write_source(FILE* out, Int8 const * script, Size len) {
+  std::vector<DecodedInstruction> code = decode_script(script,len);
+  fprintf(out,"// %d-byte script translated by proto -native\n"
+          "#include <instructions.hpp>\n",(int)len);
+  for(int i=0;i<sizeof(instruction_files)/sizeof(char*);i++)
+    fprintf(out,"#include <instructions/%s.cpp>\n",instruction_files[i]);
+  fprintf(out,"\nextern \"C\" __attribute__((visibility(\"default\")))\n"
+          "void proto_native_run(Machine & m) {\n"
+          "  Int8 const * const base = m.currentScript();\n"
+          " dispatch:\n"
+          "  if(m.finished()) return;\n"
+          "  switch((Int8 const *)m.instruction_pointer - base) {\n");
+  for(Size i = 0; i < code.size(); i++) {
+    DecodedInstruction const & d = code[i];
+    OpcodeInfo const & op = opcode_info(d.opcode);
+    Size next = d.offset + d.length;
+    fprintf(out,"  case %d:",(int)d.offset);
+    // instructions without operands never look at the instruction pointer,
+    // so it is only brought up to date for those that do
+    if(*op.operands || op.is_flow)
+      fprintf(out," m.instruction_pointer = Address(base+%d);",(int)d.offset+1);
+    fprintf(out," Instructions::%s(m);\n",op.name);
+    if(op.is_flow)
+      fprintf(out,"    goto dispatch;\n");
+    else if(i+1 == code.size() || code[i+1].offset != next)
+      fprintf(out,"    m.instruction_pointer = Address(base+%d);"
+              " goto dispatch;\n",(int)next);
+  }
+  fprintf(out,"  default: m.step(); goto dispatch;\n  }\n}\n");
+}
+
+NativeRun NativeCompiler::compile(Int8 const * script, Size len) {
+  std::string key((const char*)script,len);
+  std::map<std::string,NativeRun>::iterator found = compiled.find(key);
+  if(found != compiled.end()) return found->second;
+
+  char stem[1024];
+  snprintf(stem,sizeof(stem),"%s/script%d",dir.c_str(),count++);
+  std::string source = std::string(stem)+".cpp", lib = std::string(stem)+".so";
+  FILE* out = fopen(source.c_str(),"w");
+  if(!out) uerror("-native: couldn't write %s",source.c_str());
+  write_source(out,script,len); fclose(out);
+  std::string command = cxx + " " + flags +
+    " -shared -fPIC -fvisibility=hidden " NATIVE_INCLUDES " -o " + lib +
+    " " + source;
+  if(system(command.c_str()))
+    uerror("-native: couldn't compile %s (%s)",source.c_str(),command.c_str());
+  // never closed: devices keep running the code until the sim ends
+  void* handle = dlopen(lib.c_str(),RTLD_NOW|RTLD_LOCAL);
+  NativeRun run = handle ? (NativeRun)dlsym(handle,"proto_native_run") : NULL;
+  if(!run) uerror("-native: couldn't load %s (%s)",lib.c_str(),dlerror());
+  if(!keep) { unlink(source.c_str()); unlink(lib.c_str()); }
+  compiled[key] = run;
+  return run;
+}
@@ -0,0 +1,41 @@
+/* Ahead-of-time translation of scripts to native code
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __NATIVE__
+#define __NATIVE__
+
+#include <map>
+#include <string>
+#include <machine.hpp>
+#include "utils.h"
+
+// With -native, each script is translated to C++ when it is loaded: one
+// function with a case for every instruction, in address order, so that
+// straight-line code falls through from one instruction to the next and
+// only jumps, calls and returns go back through a dispatch.  The function
+// is compiled into a shared library with the host compiler, loaded, and run
+// in place of the interpreter loop.  Instructions it could not decode (the
+// platform's own opcodes, and anything only reachable past one) are handed
+// to the interpreter one step at a time.
+typedef void (*NativeRun)(Machine & machine); // runs until finished()
+
+class NativeCompiler {
+  std::string cxx, flags;  // how to compile, see -native-cxx, -native-flags
+  std::string dir;         // where sources and libraries go
+  bool keep;               // leave them there? (-native-dir)
+  std::map<std::string,NativeRun> compiled; // by script contents
+  int count;               // libraries made so far, for naming them
+ public:
+  NativeCompiler(Args* args);
+  ~NativeCompiler();
+  // a script that cannot be compiled is a fatal error: -native was asked for
+  NativeRun compile(Int8 const * script, Size len);
+  static void write_source(FILE* out, Int8 const * script, Size len);
+};
+
+#endif // __NATIVE__
@@ -0,0 +1,136 @@
+/* Counts of the instructions the VMs execute, for profiling scripts
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include <string>
+#include <algorithm>
+#include <sys/time.h>
+#include "profile.h"
+#include "utils.h"
+
+extern map<string,uint8_t> OPCODE_MAP;
+
+// names by opcode, looked up once instead of searching OPCODE_MAP each time
+const char* opcode_name(Int8 opcode) {
+  static vector<string> names;
+  if(names.empty()) {
+    names.assign(256,"?");
+    for(map<string,uint8_t>::iterator i = OPCODE_MAP.begin();
+        i != OPCODE_MAP.end(); i++)
+      names[i->second] = i->first;
+  }
+  return names[opcode].c_str();
+}
+
+// The host's cycle counter where it has one, microseconds elsewhere
+static inline uint64_t cycles() {
+#if defined(__i386__) || defined(__x86_64__)
+  uint32_t lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
+#else
+  struct timeval tv; gettimeofday(&tv,NULL);
+  return (uint64_t)tv.tv_sec*1000000 + tv.tv_usec;
+#endif
+}
+
+Profiler::Profiler(const char* filename)
+  : filename(filename), pairs(256*256,0), last_opcode(-1) {}
+
+Profiler::~Profiler() {
+  FILE* out = fopen(filename.c_str(),"w");
+  if(!out) { post("Couldn't open profile file %s\n",filename.c_str()); return; }
+  report(out);
+  fclose(out);
+}
+
+// The functions being run are tracked alongside the callback stack: a run
+// starts with one callback, and each call pushes another until it returns.
+void Profiler::step(Machine* vm, int uid) {
+  DeviceCounts & device = devices[uid];
+  if(calls.empty()) { // a run starts
+    device.runs++;
+    last_opcode = -1;
+    calls.push_back(vm->script_offset());
+  }
+  Int8 opcode = *vm->instruction_pointer;
+  Size depth = vm->call_depth();
+  Counts & function = functions[calls.back()];
+  uint64_t start = cycles();
+  vm->step();
+  uint64_t spent = cycles() - start;
+  opcodes[opcode].executed++; opcodes[opcode].cycles += spent;
+  function.executed++; function.cycles += spent;
+  device.executed++; device.cycles += spent;
+  if(last_opcode>=0) pairs[256*last_opcode+opcode]++;
+  last_opcode = opcode;
+  Size now = vm->call_depth();
+  if(now > depth) calls.push_back(vm->script_offset());
+  while(calls.size() > now) calls.pop_back();
+}
+
+// entries of a section, most executed first
+template<class K> static void sort_by_count(vector<pair<uint64_t,K> > & v) {
+  sort(v.begin(),v.end());
+  reverse(v.begin(),v.end());
+}
+
+static double per(uint64_t a, uint64_t b) { return b ? (double)a/b : 0; }
+
+void Profiler::report(FILE* out) {
+  DeviceCounts total;
+  for(map<int,DeviceCounts>::iterator i = devices.begin(); i != devices.end(); i++) {
+    total.runs += i->second.runs;
+    total.executed += i->second.executed; total.cycles += i->second.cycles;
+  }
+  fprintf(out,"%% %llu instructions in %llu runs on %d devices, %llu cycles\n",
+          (unsigned long long)total.executed, (unsigned long long)total.runs,
+          (int)devices.size(), (unsigned long long)total.cycles);
+
+  vector<pair<uint64_t,int> > ops;
+  for(int i = 0; i < 256; i++)
+    if(opcodes[i].executed) ops.push_back(make_pair(opcodes[i].executed,i));
+  sort_by_count(ops);
+  fprintf(out,"%% opcode executed cycles cycles/executed\n");
+  for(Size i = 0; i < ops.size(); i++) {
+    Counts const & c = opcodes[ops[i].second];
+    fprintf(out,"%s %llu %llu %.1f\n",opcode_name(ops[i].second),
+            (unsigned long long)c.executed,(unsigned long long)c.cycles,
+            per(c.cycles,c.executed));
+  }
+
+  vector<pair<uint64_t,int> > seq;
+  for(int i = 0; i < 256*256; i++)
+    if(pairs[i]) seq.push_back(make_pair(pairs[i],i));
+  sort_by_count(seq);
+  fprintf(out,"%% pair executed\n");
+  for(Size i = 0; i < seq.size(); i++)
+    fprintf(out,"%s %s %llu\n",opcode_name(seq[i].second/256),
+            opcode_name(seq[i].second%256),(unsigned long long)seq[i].first);
+
+  vector<pair<uint64_t,Size> > funs;
+  for(map<Size,Counts>::iterator i = functions.begin(); i != functions.end(); i++)
+    funs.push_back(make_pair(i->second.executed,i->first));
+  sort_by_count(funs);
+  fprintf(out,"%% function executed cycles cycles/executed\n");
+  for(Size i = 0; i < funs.size(); i++) {
+    Counts const & c = functions[funs[i].second];
+    fprintf(out,"@%d %llu %llu %.1f\n",(int)funs[i].second,
+            (unsigned long long)c.executed,(unsigned long long)c.cycles,
+            per(c.cycles,c.executed));
+  }
+
+  fprintf(out,"%% device runs executed cycles executed/run cycles/run\n");
+  for(map<int,DeviceCounts>::iterator i = devices.begin(); i != devices.end(); i++) {
+    DeviceCounts const & c = i->second;
+    fprintf(out,"%d %llu %llu %llu %.1f %.1f\n",i->first,
+            (unsigned long long)c.runs,(unsigned long long)c.executed,
+            (unsigned long long)c.cycles,per(c.executed,c.runs),
+            per(c.cycles,c.runs));
+  }
+}
@@ -0,0 +1,55 @@
+/* Counts of the instructions the VMs execute, for profiling scripts
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __PROFILE__
+#define __PROFILE__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <machine.hpp>
+using namespace std;
+
+// The name of an opcode, or "?" if it has none
+const char* opcode_name(Int8 opcode);
+
+// A profile (-profile FILE) counts every instruction the VMs execute in
+// their runs, with the host cycles it took: by opcode, by function and by
+// device, and how often each opcode follows each other within a run.  A
+// function is known by the offset of its first instruction in the script,
+// and is charged only for its own instructions, not for those of the
+// functions it calls.  The report is written as text when the profile is
+// deleted, most frequent first in each section.
+class Profiler {
+  struct Counts {
+    uint64_t executed, cycles;
+    Counts() : executed(0), cycles(0) {}
+  };
+  struct DeviceCounts : Counts {
+    uint64_t runs;
+    DeviceCounts() : runs(0) {}
+  };
+  string filename;
+  Counts opcodes[256];
+  vector<uint64_t> pairs;            // 256 * previous + next
+  map<Size,Counts> functions;        // by script offset
+  map<int,DeviceCounts> devices;     // by uid
+  vector<Size> calls;                // functions entered in the current run
+  int last_opcode;                   // in the current run, or -1
+ public:
+  Profiler(const char* filename);
+  ~Profiler();                       // writes the report
+  // execute the next instruction of a device's VM, counting it
+  void step(Machine* vm, int uid);
+ private:
+  void report(FILE* out);
+};
+
+#endif // __PROFILE__
@@ -55,6 +55,58 @@ bool RadioSim::handle_key(KeyEvent* key) {
   return false;
 }
 
+int RadioSim::slot_size(Data const & d) {
+  int size = 1; // type byte
+  switch(d.type()) {
+  case Data::Type_number: size += sizeof(Number); break;
+  case Data::Type_address: size += sizeof(Address); break;
+  case Data::Type_tuple: {
+    Tuple const & t = d.asTuple();
+    size++; // length byte
+    for(Index i = 0; i < t.size(); i++) size += slot_size(t[i]);
+    break;
+  }
+  default: break;
+  }
+  return size;
+}
+
+int RadioSim::export_size(Array<Data> const & data) {
+  int size = EXPORT_HEADER_SIZE;
+  for(Size i = 0; i < data.size(); i++) size += slot_size(data[i]);
+  return size;
+}
+
+int RadioSim::sent_size(Array<Data> const & data,
+                        vector<bool> const * changed) {
+  if(!changed) return export_size(data);
+  int size = EXPORT_HEADER_SIZE;
+  for(Size i = 0; i < data.size(); i++)
+    if((*changed)[i]) size += 1 + slot_size(data[i]); // index byte + slot
+  return size;
+}
+
+Neighbour* RadioSim::receive_export(Machine* vm, int src_id, uint8_t seq,
+                                    Array<Data> const & data,
+                                    vector<bool> const * changed) {
+  Neighbour* nbr;
+  if(!changed) {
+    nbr = &vm->hood[src_id];
+    for(Size i = 0; i < data.size(); i++) nbr->imports[i] = data[i];
+  } else {
+    NeighbourHood::iterator i = vm->hood.find(src_id);
+    if(i == vm->hood.end() || i->export_seq != (uint8_t)(seq-1))
+      return NULL; // missed the export this delta builds on
+    nbr = &*i;
+    for(Size j = 0; j < data.size(); j++)
+      if((*changed)[j]) nbr->imports[j] = data[j];
+  }
+  nbr->export_seq = seq;
+  nbr->heard_round = vm->rounds;
+  nbr->heard_time = parent->sim_time;
+  return nbr;
+}
+
 bool RadioSim::try_tx() {
   return tx_error==0 || urnd(0,1) > tx_error;
 }
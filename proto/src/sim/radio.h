@@ -27,13 +27,41 @@ class RadioSim : public Layer, public HardwarePatch {
   
   virtual bool handle_key(KeyEvent* key);
 
+  // bytes an export occupies on the air: a header (version, source id,
+  // slot count), then each slot as a type byte and its value; tuples
+  // carry a length byte.  Link-layer framing is not included.
+  static const int EXPORT_HEADER_SIZE = 4;
+  static int export_size(Array<Data> const & data);
+  static int slot_size(Data const & d);
+  // With -delta-exports, a delta sends only the changed slots, each
+  // prefixed by an index byte.  changed is NULL for a full export.
+  static vector<bool> const * delta_of(Device* d)
+    { return d->export_is_delta ? &d->export_changed : NULL; }
+  static int sent_size(Array<Data> const & data, vector<bool> const * changed);
+  // Hand an export to a receiving VM, returning its hood entry stamped
+  // with the receiver's round and the time.  Each export carries the
+  // sender's broadcast count in its version byte (seq), and the entry
+  // keeps the seq it was last updated from.  A delta is merged only if it
+  // directly follows that export; if the receiver missed one in between,
+  // the delta is dropped and NULL is returned, leaving the entry as it
+  // was until the next full refresh.
+  Neighbour* receive_export(Machine* vm, int src_id, uint8_t seq,
+                            Array<Data> const & data,
+                            vector<bool> const * changed);
+
+  // Who would hear the current device's export, and where the sender is
+  // relative to each, before any loss.  Radios that can list receivers
+  // without side effects return true, so MultiRadio can merge their
+  // deliveries; the rest return false and are left to send on their own.
+  struct Reception { Device* rx; METERS dp[3]; };
+  virtual bool list_receivers(vector<Reception>* out) { return false; }
+
+  bool try_tx();
+  bool try_rx();
+
   static Color *NET_CONNECTION_FUZZY, *NET_CONNECTION_SHARP, 
     *NET_CONNECTION_LOGICAL, *RADIO_BACKOFF;
   virtual void register_colors();
-  
-protected:
-  bool try_tx();
-  bool try_rx();
 };
 
 #endif
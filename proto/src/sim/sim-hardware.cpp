@@ -8,6 +8,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 
 #include "config.h"
 #include "spatialcomputer.h"
+#include "trace.h"
 #include <iostream>
 #include <sstream>
 
@@ -50,6 +51,7 @@ SimulatedHardware::SimulatedHardware() {
 //  dumpPatchTable();
 
     opHandlerCount = 0;
+    trace = NULL;
 }
 
 int SimulatedHardware::registerOpcode(OpHandlerBase* opHandler) {
@@ -64,7 +66,9 @@ void SimulatedHardware::dispatchOpcode(uint8_t op) {
     // TODO Out-of-range should throw exception or something
     return;
   }
+  if(trace) trace->before_op(machine);
   (*opHandlers[ix])(machine);
+  if(trace) trace->after_op();
 }
 
 void SimulatedHardware::appendDefops(string& defops) {
@@ -128,12 +132,15 @@ void set_probe (Data d, uint8_t p)
 void set_dt (Number dt)
 { hardware->patch_table[SET_DT_FN]->set_dt(dt);}
 
+// sensor values go into the trace, if one is being recorded
+static Number traced(Number v)
+{ if(hardware->trace) hardware->trace->reading(v); return v; }
 Number read_radio_range () 
-{ return hardware->patch_table[READ_RADIO_RANGE_FN]->read_radio_range(); }
+{ return traced(hardware->patch_table[READ_RADIO_RANGE_FN]->read_radio_range()); }
 Number read_bearing () 
-{ return hardware->patch_table[READ_BEARING_FN]->read_bearing(); }
+{ return traced(hardware->patch_table[READ_BEARING_FN]->read_bearing()); }
 Number read_speed () 
-{ return hardware->patch_table[READ_SPEED_FN]->read_speed(); }
+{ return traced(hardware->patch_table[READ_SPEED_FN]->read_speed()); }
 
 int radio_send_export (uint8_t version, Array<Data> const & data) {
   return hardware->patch_table[RADIO_SEND_EXPORT_FN]->
@@ -229,7 +236,7 @@ void post_data_to2(char * str, Data data, int verbosity) {
 			strcpy(str, "(UNDEFINED)");
 			break;
 		case Data::Type_number:
-			sprintf(str, "%.2f", data.asNumber());
+			sprintf(str, "%.2f", Number_toDouble(data.asNumber()));
 			break;
 		case Data::Type_tuple: {
 			char buf[100];
@@ -128,7 +128,7 @@ template <class Tclass> class OpHandler : public OpHandlerBase {
 #define PLATFORM_OPCODE_OFFSET 200
 
 // This class dispatches kernel hardware calls to the appropriate patches
-class Device;
+class Device; class TraceWriter;
 class SimulatedHardware {
   OpHandlerBase* opHandlers[PLATFORM_OPCODE_MAX_COUNT];
   int opHandlerCount;
@@ -139,6 +139,7 @@ public:
   HardwarePatch* patch_table[NUM_HARDWARE_FNS];
   vector<HardwareFunction> requiredPatches; // corresponding to // Universal sensing & actuation ops
   vector<const char*> requiredOpcodes;
+  TraceWriter* trace; // records sensor values and platform ops, or NULL
   SimulatedHardware();
   void patch(HardwarePatch* p, HardwareFunction fn); // instantiate a fn
   void set_vm_context(Device* d); // prepare globals for kernel execution
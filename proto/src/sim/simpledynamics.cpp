@@ -363,13 +363,13 @@ bool SimpleDynamics::evolve(SECONDS dt) {
 
 // There is no subtlety here: mov just sets velocity directly
 void SimpleDynamics::mov(Tuple v) {
-  flo x = v[0].asNumber();
-  flo y = v[1].asNumber();
-  flo z = v.size() > 2 ? v[2].asNumber() : 0;
+  flo x = Number_toDouble(v[0].asNumber());
+  flo y = Number_toDouble(v[1].asNumber());
+  flo z = v.size() > 2 ? Number_toDouble(v[2].asNumber()) : 0;
   device->body->set_velocity(x,y,z);
 }
 // sensing & actuation of body radius
 Number SimpleDynamics::radius_set (Number val)
-{ return ((SimpleBody*)device->body)->radius = val; }
+{ ((SimpleBody*)device->body)->radius = Number_toDouble(val); return val; }
 Number SimpleDynamics::radius_get () 
 { return ((SimpleBody*)device->body)->radius; }
@@ -17,8 +17,8 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "visualizer.h"
 #include "plugin_manager.h"
 #include "DefaultsPlugin.h"
-
-extern map<string,uint8_t> OPCODE_MAP;
+#include "trace.h"
+#include "bytecode.h"
 
 /*****************************************************************************
  *  DEVICE                                                                   *
@@ -35,7 +35,12 @@ Device::Device(SpatialComputer* parent, METERS *loc, DeviceTimer *timer) {
   for(int i=0;i<num_layers;i++) 
     { Layer* l = (Layer*)parent->dynamics.get(i); if(l) l->add_device(this); }
   //vm = allocate_machine(); // unusable until script is loaded
-  vm = new Machine();
+  vm = new Machine(); native_run = NULL; is_verified = false;
+  is_lockstep = false;
+  round_reads = 0;
+  vm->hood_timeout = parent->hood_timeout;
+  vm->hood_timeout_secs = parent->hood_timeout_secs;
+  export_is_delta=false; exports_since_full=0; export_seq=0;
   is_selected=false; is_debug=false;
   if (parent->print_stack_id == uid) {
 	  is_print_stack = true;
@@ -57,13 +62,10 @@ Device* Device::clone_device(METERS *loc) {
   //  new_machine(vm, uid, 0, 0, 0, 1, script, len);
   //uint8_t *copy_src = vm->membuf, *copy_dst = new_d->vm->membuf;
   //for(int i=0;i<vm->memlen;i++) { copy_dst[i]=copy_src[i]; }
-  new_d->load_script(vm->currentScript(),vm->currentScript().size());
-  // copy over state
-  
-  //new_d->vm->time = vm->time;  new_d->vm->last_time = vm->last_time;
-  for(size_t i = 0; i < new_d->vm->threads.size(); i++) {
-    new_d->vm->threads[i] = vm->threads[i];
-  }
+  // the clone takes the machine as it is: its globals and threads, and
+  // then its state
+  new_d->load_script(vm->currentScript(),vm->currentScript().size(),vm);
+  new_d->vm->copy_state(*vm);
   
   new_d->run_time=run_time; new_d->is_selected=is_selected; 
   //new_d->is_debug=is_debug;
@@ -89,11 +91,11 @@ Device::~Device() {
 void Device::dump_state(FILE* out, int verbosity) {
   // dump heading information
   if(verbosity==0) {
-    fprintf(out,"%d %.2f %.2f",uid,1.0f/*ticks*/,vm->startTime());
+    fprintf(out,"%d %.2f %.2f",uid,1.0f/*ticks*/,Number_toDouble(vm->startTime()));
   } else {
     fprintf(out,"Device %d ",uid);
     if(verbosity>=2) fprintf(out,"[in slot %d]",backptr);
-    fprintf(out,"(Internal time: %.2f %.2f)\n",1.0f/*ticks*/,vm->startTime());
+    fprintf(out,"(Internal time: %.2f %.2f)\n",1.0f/*ticks*/,Number_toDouble(vm->startTime()));
     if(verbosity>=2) 
       fprintf(out,"Selected = %s, Debug = %s\n",bool2str(is_selected),
               bool2str(is_debug));
@@ -118,6 +120,12 @@ void Device::dump_state(FILE* out, int verbosity) {
     }
   }
   
+  // did its script pass verification with known bounds (see verify.h)?
+  if(parent->is_dump_verified) {
+    if(verbosity==0) fprintf(out," %d",is_verified);
+    else fprintf(out,"Verified = %s\n",bool2str(is_verified));
+  }
+
   // dump neighborhood data
   if(verbosity>=1 && parent->is_dump_hood) {
     char buf[1000];
@@ -125,13 +133,17 @@ void Device::dump_state(FILE* out, int verbosity) {
     for(int i=0;i<vm->thisMachine().imports.size();i++) {
       post_data_to(buf,vm->thisMachine().imports[i]); fprintf(out,"%s ",buf);
     }
-    fprintf(out,"\nNeighbor Values: (%d neighbors) \n",(int)vm->hood.size()); // then neighbor data
+    int n_fresh = 0;
+    for(NeighbourHood::iterator i=vm->hood.begin(); i != vm->hood.end(); i++)
+      if(!vm->expired(*i)) n_fresh++;
+    fprintf(out,"\nNeighbor Values: (%d neighbors) \n",n_fresh); // then neighbor data
     for(NeighbourHood::iterator i=vm->hood.begin(); i != vm->hood.end(); i++) {
       Neighbour const & nbr = *i;
+      if(vm->expired(nbr)) continue;
       fprintf(out,
               "Neighbor %4d [X=%.2f, Y=%.2f, Z=%.2f, Range=%.2f]: ",
-              nbr.id, nbr.x, nbr.y, nbr.z,
-              sqrt(nbr.x*nbr.x + nbr.y*nbr.y + nbr.z*nbr.z));
+              nbr.id, Number_toDouble(nbr.x), Number_toDouble(nbr.y), Number_toDouble(nbr.z),
+              Number_toDouble(sqrt(nbr.x*nbr.x + nbr.y*nbr.y + nbr.z*nbr.z)));
 	for(int j=0;j<vm->thisMachine().imports.size();j++) {
 	  post_data_to(buf,nbr.imports[j]); fprintf(out,"%s ",buf);
 	}
@@ -142,23 +154,134 @@ void Device::dump_state(FILE* out, int verbosity) {
   if(verbosity==0) fprintf(out,"\n"); // terminate line
 }
 
-void Device::load_script(uint8_t const * script, int len) {
+extern Number read_radio_range();
+
+// Does installing a script leave every machine alike but for its id?  Not
+// if the installation code reads the device it runs on: its id, hood,
+// sensors, time or randomness, or platform ops, or branches.
+static bool installs_alike(uint8_t const * script, int len) {
+  static const char* device[] = {
+    "MID", "RND", "DT", "SPEED", "BEARING", "AREA", "DENSITY", "HOOD_RADIUS",
+    "INFINITESIMAL", "NBR_RANGE", "NBR_BEARING", "NBR_VEC", "NBR_LAG",
+    "FLEX", "MOV", "PROBE", "SET_DT" };
+  DecodedInstruction d;
+  for(Size at = 0; decode_at(script,len,at,d); ) {
+    const char* key = opcode_info(d.opcode).key;
+    if(!strcmp(key,"EXIT")) return true;
+    for(int k=0;k<sizeof(device)/sizeof(device[0]);k++)
+      if(!strcmp(key,device[k])) return false;
+    if(strstr(key,"DEF_FUN")) { at = d.target; continue; } // skip the body
+    if(opcode_info(d.opcode).is_flow && strcmp(key,"DEF_VM")) return false;
+    at += d.length;
+  }
+  return false; // a platform op, or no EXIT
+}
+
+// What the runs of a script read besides the hood and state, for
+// -skip-unchanged; 0 if they read anything else that may change from round
+// to round: time, randomness, sensors, or platform ops, whose effects are
+// unknown.  Actuators are left running too.  The inputs are those of the
+// device's last run, so only scripts with a single thread, always due but
+// for its period, qualify: not DEF_VM_EX, which may declare more, nor
+// scripts that activate or trigger threads.
+static int script_round_reads(uint8_t const * script, int len) {
+  static const char* changing[] = {
+    "RND", "DT", "NBR_LAG", "SPEED", "BEARING", "FLEX", "MOV", "PROBE",
+    "DEF_VM_EX", "ACTIVATE", "DEACTIVATE", "TRIGGER" };
+  static const char* radio[] = {
+    "HOOD_RADIUS", "AREA", "DENSITY", "INFINITESIMAL" };
+  std::vector<DecodedInstruction> code = decode_script(script,len);
+  std::set<Size> decoded;
+  for(int i=0;i<code.size();i++) decoded.insert(code[i].offset);
+  int reads = READS_HOOD;
+  for(int i=0;i<code.size();i++) {
+    Size next = code[i].offset + code[i].length;
+    if(next < len && !decoded.count(next)) return 0; // stopped at a platform op
+    const char* key = opcode_info(code[i].opcode).key;
+    for(int k=0;k<sizeof(changing)/sizeof(changing[0]);k++)
+      if(!strcmp(key,changing[k])) return 0;
+    for(int k=0;k<sizeof(radio)/sizeof(radio[0]);k++)
+      if(!strcmp(key,radio[k])) reads |= READS_RANGE;
+  }
+  return reads;
+}
+
+// Can the runs of a script be stepped in lockstep with other devices'?
+// Not if it has platform ops, which may reach into other devices (a radio
+// op can drop a neighbour from a hood being folded), or draws random
+// numbers, whose order would then differ from running each VM on its own.
+// Nor if it may have more than one thread (DEF_VM_EX): a lockstep group
+// runs a single thread of each device.
+static bool script_lockstep_safe(uint8_t const * script, int len) {
+  std::vector<DecodedInstruction> code = decode_script(script,len);
+  std::set<Size> decoded;
+  for(int i=0;i<code.size();i++) decoded.insert(code[i].offset);
+  for(int i=0;i<code.size();i++) {
+    Size next = code[i].offset + code[i].length;
+    if(next < len && !decoded.count(next)) return false; // a platform op
+    const char* key = opcode_info(code[i].opcode).key;
+    if(!strcmp(key,"RND") || !strcmp(key,"DEF_VM_EX")) return false;
+  }
+  return true;
+}
+
+void RoundInputs::capture(Machine* vm, SECONDS time, int reads) {
+  ids.clear(); positions.clear(); imports.clear(); state.clear();
+  NeighbourHood::iterator i = vm->hood.begin();
+  for(i++; i != vm->hood.end(); i++) { // our own exports are outputs
+    if(vm->expired(*i,time)) continue;
+    ids.push_back(i->id);
+    positions.push_back(i->x); positions.push_back(i->y);
+    positions.push_back(i->z);
+    for(Size k = 0; k < i->imports.size(); k++) imports.push_back(i->imports[k]);
+  }
+  for(Size k = 0; k < vm->state.size(); k++) state.push_back(vm->state[k].data);
+  range = (reads & READS_RANGE) ? read_radio_range() : Number(0);
+  valid = true;
+}
+
+static bool same_data(std::vector<Data> const & a, std::vector<Data> const & b) {
+  if(a.size()!=b.size()) return false;
+  for(Size i = 0; i < a.size(); i++) if(!same_data(a[i],b[i])) return false;
+  return true;
+}
+
+bool RoundInputs::same_as(RoundInputs const & o) const {
+  return valid && o.valid && range==o.range && ids==o.ids &&
+    positions==o.positions && same_data(imports,o.imports) &&
+    same_data(state,o.state);
+}
+
+void RoundInputs::swap(RoundInputs & o) {
+  std::swap(valid,o.valid); std::swap(range,o.range);
+  ids.swap(o.ids); positions.swap(o.positions);
+  imports.swap(o.imports); state.swap(o.state);
+}
+
+// A round may skip its run if what the run reads is as the last run found
+// it: the run would leave the result, state and exports as they are.
+bool Device::inputs_unchanged(SECONDS time) {
+  inputs.capture(vm,time,round_reads);
+  if(inputs.same_as(last_inputs)) return true;
+  last_inputs.swap(inputs);
+  return false;
+}
+
+void Device::load_script(uint8_t const * script, int len,
+                         Machine const * installed) {
   //new_machine(vm, uid, 0, 0, 0, 1, script, len);
   vm->id = uid;
-  vm->install(Script(script,len));
+  ScriptBounds const * bounds = parent->verify(script,len);
+  if(parent->hardware.trace) parent->hardware.trace->load(vm,script,len);
+  if(installed && !is_print_stack && !is_print_env_stack)
+    vm->install_as(*installed);
+  else
+    vm->install(Script(script,len));
   int iStep = 0;
   while(!vm->finished()) {
 	 	if (is_print_stack || is_print_env_stack) {
 	    	Int8 opcode = *(vm->instruction_pointer);
-	    	cout << "OpCode: " << (int)opcode;
-	    	Instruction i = instructions[opcode];
-	   		map<string,uint8_t>::iterator it;
-	   		for ( it=OPCODE_MAP.begin() ; it != OPCODE_MAP.end(); it++ ) {
-	   			if ((*it).second == opcode) {
-	   				cout << " " << (*it).first;
-    				break;
-	   			}
-	   		}
+	    	cout << "OpCode: " << (int)opcode << " " << opcode_name(opcode);
 	 	}
 	 	if (is_print_stack) {
 	 		cout << " Stack (" << iStep << "): ";
@@ -171,6 +294,19 @@ void Device::load_script(uint8_t const * script, int len) {
      	iStep++;
 	    vm->step();
     }
+  // a bounded script gets all its stack space now, and runs unchecked
+  is_verified = bounds && bounds->bounded;
+  if(is_verified)
+    vm->reserve(bounds->stack,bounds->environment,bounds->callbacks,
+                bounds->feedback);
+  // -skip-unchanged: a new script starts with a run
+  round_reads = parent->is_skip_unchanged ? script_round_reads(script,len) : 0;
+  is_lockstep = parent->lockstep_width && script_lockstep_safe(script,len);
+  last_inputs.valid = false;
+  // devices whose every step is printed or profiled stay with the interpreter
+  native_run = (parent->native && !parent->profile && !is_print_stack &&
+                !is_print_env_stack) ?
+    parent->native->compile(script,len) : NULL;
 }
 
 // a convenient combined function
@@ -188,62 +324,105 @@ void Device::text_scale() {
 
 extern void radio_send_export(uint8_t version, Array<Data> const & data);
 
+// Decide whether the coming broadcast can be a delta against the last one,
+// and if so which slots it must carry.  A full export goes out every
+// delta_refresh broadcasts, and whenever the export layout has changed.
+void Device::mark_export_changes() {
+  Array<Data> const & now = vm->thisMachine().imports;
+  export_is_delta = last_export.size()==now.size() &&
+    ++exports_since_full < parent->delta_refresh;
+  if(export_is_delta) {
+    for(Size i = 0; i < now.size(); i++)
+      export_changed[i] = !same_data(now[i],last_export[i]);
+  } else {
+    exports_since_full = 0;
+    export_changed.assign(now.size(),true);
+  }
+}
+
+// Run a VM to the end without checking each opcode for a platform op, for
+// scripts verify_script found bounded: they contain none.
+static inline void run_verified(Machine* vm) {
+  while(!vm->finished()) instructions[vm->nextInt8()](*vm);
+}
+
+// A compute is split in two around the running of the VM, so that
+// SpatialComputer can run the VMs of a synchronous round in lockstep.
+void Device::begin_compute(SECONDS time) {
+  body->preupdate(); // run the pre-compute update
+  for(int i=0;i<num_layers;i++)
+    { DeviceLayer* d = (DeviceLayer*)layers[i]; if(d) d->preupdate(); }
+  // stale neighbours are dropped as the hood is folded (see expired())
+  vm->rounds++;
+  vm->thisMachine().heard_round = vm->rounds;
+  vm->thisMachine().heard_time = time;
+  if(parent->hardware.trace) parent->hardware.trace->compute(vm,time);
+  start_run(time);
+}
+
+// Start the run of the next thread due, or under -skip-unchanged account
+// for a run that would compute what the last one did.
+void Device::start_run(SECONDS time) {
+  if(round_reads && inputs_unchanged(time)) vm->skip_run(time);
+  else vm->run(time);
+}
+
+void Device::end_compute() {
+  body->update(); // run the post-compute update
+  for(int i=0;i<num_layers;i++)
+    { DeviceLayer* d = (DeviceLayer*)layers[i]; if(d) d->update(); }
+}
+
 void Device::internal_event(SECONDS time, DeviceEvent type) {
   int iStep = 0;
   switch(type) {
   case COMPUTE:
-    body->preupdate(); // run the pre-compute update
-    for(int i=0;i<num_layers;i++)
-      { DeviceLayer* d = (DeviceLayer*)layers[i]; if(d) d->preupdate(); }
-    {
-      vm->thisMachine().data_age = 0;
-      for( NeighbourHood::iterator i = vm->hood.begin(); i != vm->hood.end(); ){
-        if (i->data_age > 1) {
-          i = vm->hood.remove(i);
-        } else {
-          i->data_age++;
-          ++i;
-        }
+    if(!vm->due(time)) break; // no thread wants to run yet: an idle tick
+    begin_compute(time);
+    for(Size runs = 1; ; runs++) {
+      if(native_run) native_run(*vm); // runs to the end, as the loop below does
+      else if(is_verified && !parent->profile && !is_print_stack &&
+              !is_print_env_stack)
+        run_verified(vm);
+      while(!vm->finished()) {
+      	if (is_print_stack || is_print_env_stack) {
+      		Int8 opcode = *(vm->instruction_pointer);
+      		cout << "OpCode: " << (int)opcode << " " << opcode_name(opcode);
+      	}
+      	if (is_print_stack) {
+      	  cout << " Stack (" << iStep << "): ";
+      	  vm->print_stack(&vm->stack);
+      	}
+      	if (is_print_env_stack) {
+      	  cout << " Environment Stack (" << iStep << "): ";
+      	  vm->print_stack(&vm->environment);
+      	}
+      	iStep++;
+      	if(parent->profile) parent->profile->step(vm,uid);
+      	else vm->step();
       }
-    }
-    vm->run(time);
-    while(!vm->finished()) {
-    	if (is_print_stack || is_print_env_stack) {
-    		Int8 opcode = *(vm->instruction_pointer);
-    		cout << "OpCode: " << (int)opcode;
-    		Instruction i = instructions[opcode];
-    		map<string,uint8_t>::iterator it;
-    		for ( it=OPCODE_MAP.begin() ; it != OPCODE_MAP.end(); it++ ) {
-    			if ((*it).second == opcode) {
-    				cout << " " << (*it).first;
-    				break;
-    			}
-    		}
-    	}
-    	if (is_print_stack) {
-    	  cout << " Stack (" << iStep << "): ";
-    	  vm->print_stack(&vm->stack);
-    	}
-    	if (is_print_env_stack) {
-    	  cout << " Environment Stack (" << iStep << "): ";
-    	  vm->print_stack(&vm->environment);
-    	}
-    	iStep++;
-    	vm->step();
+      // every thread due at this tick runs, each once, whatever its period;
+      // a run cut short never counts as run, so the runs are also counted
+      if(runs >= vm->threads.size() || !vm->due(time)) break;
+      start_run(time);
     }
     if (is_print_stack || is_print_env_stack) {
     	cout << endl;
     }
-    body->update(); // run the post-compute update
-    for(int i=0;i<num_layers;i++)
-      { DeviceLayer* d = (DeviceLayer*)layers[i]; if(d) d->update(); }
+    end_compute();
     break;
   case BROADCAST:
     //export_machine();
     /*if(script_export_needed() || (((int)vm->ticks) % 10)==0) {
       export_script(); // send script every 10 rounds, or as needed
     }*/
-    radio_send_export(0,vm->thisMachine().imports);
+    if(parent->delta_refresh) mark_export_changes();
+    for(int i=0;i<num_layers;i++) {
+      DeviceLayer* d = (DeviceLayer*)layers[i];
+      if(d) d->exported(vm->thisMachine().imports);
+    }
+    radio_send_export(export_seq++,vm->thisMachine().imports);
+    if(parent->delta_refresh) last_export = vm->thisMachine().imports;
     break;
   }
 }
@@ -287,9 +466,9 @@ void Device::visualize() {
     case Data::Type_tuple: {
       Tuple const & v = dst.asTuple();
       if (v.size() >= 2) {
-        flo x = v[0].asNumber();
-        flo y = v[1].asNumber();
-        flo z = v.size() > 2 ? v[2].asNumber() : 0;
+        flo x = Number_toDouble(v[0].asNumber());
+        flo y = Number_toDouble(v[1].asNumber());
+        flo z = v.size() > 2 ? Number_toDouble(v[2].asNumber()) : 0;
 	palette->use_color(SpatialComputer::VECTOR_BODY);
         glBegin(GL_LINE_STRIP);
         glVertex3f(0, 0, 0);
@@ -432,6 +611,22 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
   print_env_stack_id = (args->extract_switch("-print-env-stack"))?args->pop_number() : -1;
 
   int n=(args->extract_switch("-n"))?(int)args->pop_number():100; // # devices
+  // delta exports: send only changed slots, with a periodic full refresh
+  delta_refresh = args->extract_switch("-delta-refresh") ?
+    max(1,(int)args->pop_number()) : 10;
+  if(!args->extract_switch("-delta-exports")) delta_refresh = 0;
+  // neighbours are forgotten after this many rounds, or seconds, unheard
+  hood_timeout = args->extract_switch("-hood-timeout") ?
+    (int)args->pop_number() : 2;
+  hood_timeout_secs = args->extract_switch("-hood-timeout-secs") ?
+    args->pop_number() : 0;
+  // record what every VM sees, for offline replay with proto-replay
+  if(args->extract_switch("-record-trace"))
+    hardware.trace = new TraceWriter(args->pop_next(),hood_timeout,
+                                     hood_timeout_secs);
+  // count the instructions every VM runs, reported on exit
+  profile = args->extract_switch("-profile") ? new Profiler(args->pop_next())
+    : NULL;
   // load dumping variables
   is_dump_default=true;
   args->undefault(&is_dump_default,"-Dall","-NDall");
@@ -439,6 +634,8 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
   args->undefault(&is_dump_hood,"-Dhood","-NDhood");
   is_dump_value=is_dump_default;
   args->undefault(&is_dump_value,"-Dvalue","-NDvalue");
+  is_dump_verified=false;
+  args->undefault(&is_dump_verified,"-Dverified","-NDverified");
   is_dump = args->extract_switch("-D");
   is_probe_filter = args->extract_switch("-probe-dump-filter");
   is_show_snaps = !args->extract_switch("-no-dump-snaps");
@@ -453,6 +650,24 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
   // setup customization
   get_volume(args, n);
   initialize_plugins(args, n);
+  // translate scripts to native code as they are loaded
+  native = args->extract_switch("-native") ? new NativeCompiler(args) : NULL;
+  // check scripts before loading them, and find their stack bounds
+  is_verify = !args->extract_switch("-no-verify");
+  // skip the runs of rounds that would compute what the last one did; a
+  // trace must see every run
+  is_skip_unchanged = args->extract_switch("-skip-unchanged") && !hardware.trace;
+  is_install_alike = false; // until a script is loaded
+  // with -lockstep, synchronous rounds run their VMs in lockstep, this many
+  // at a time, unless something needs to see each VM run on its own.  It is
+  // off by default: it does not yet batch any work, and runs slower.
+  lockstep_width = args->extract_switch("-lockstep") ? 64 : 0;
+  if(args->extract_switch("-lockstep-width"))
+    lockstep_width = max(1,(int)args->pop_number());
+  if(args->extract_switch("-no-lockstep") || !time_model->is_synchronous() ||
+     hardware.trace || profile || print_stack_id>=0 || print_env_stack_id>=0 ||
+     native)
+    lockstep_width = 0;
 
   scheduler = new Scheduler(n, time_model->cycle_time());
   // create the actual devices
@@ -486,6 +701,7 @@ SpatialComputer::~SpatialComputer() {
   delete scheduler; delete volume; delete time_model; delete distribution;
   for(int i=0;i<dynamics.max_id();i++) 
     { Layer* ec = (Layer*)dynamics.get(i); if(ec) delete ec; }
+  delete hardware.trace; delete native; delete profile;
 }
 
 /*****************************************************************************
@@ -591,14 +807,31 @@ void SpatialComputer::initialize_plugins(Args* args, int n) {
  *****************************************************************************/
 // for the initial loading only
 void SpatialComputer::load_script(uint8_t* script, int len) {
+  ScriptBounds const * bounds = verify(script,len);
+  if(bounds && !bounds->ok) uerror("Rejected script: %s",bounds->error.c_str());
+  // install on one device, and copy what that leaves to the others
+  is_install_alike = installs_alike(script,len);
+  Machine const * installed = NULL;
   for(int i=0;i<devices.max_id();i++) { 
     Device* d = (Device*)devices.get(i); 
     if(d) {
       hardware.set_vm_context(d);
-      d->load_script(script,len); 
+      d->load_script(script,len,installed); 
+      if(is_install_alike && !installed) installed = d->vm;
     }
   }
 }
+// What verify_script makes of a script, worked out once for all devices
+// loading it; NULL if verification is off (-no-verify).
+ScriptBounds const * SpatialComputer::verify(uint8_t const * script, int len) {
+  if(!is_verify) return NULL;
+  std::string key((char const *)script,len);
+  std::map<std::string,ScriptBounds>::iterator i = verified.find(key);
+  if(i==verified.end())
+    i = verified.insert(std::make_pair(key,verify_script(script,len))).first;
+  return &i->second;
+}
+
 // install a script by injecting it as packets w. the next version
 void SpatialComputer::load_script_at_selection(uint8_t* script, int len) {
 	/*
@@ -735,19 +968,28 @@ bool SpatialComputer::evolve(SECONDS limit) {
     int id = (long)e.target;
     Device* d = (Device*)devices.get(id);
     if(d && d->uid==e.uid) {
+      if(lockstep_width) { // gather the computes of a synchronous round
+        if(!round.empty() && (e.type!=COMPUTE || e.true_time!=round_time)) {
+          // the round's next events may fall before this one: requeue it
+          if(finish_round() < e.true_time) {
+            scheduler->schedule_event(e.target,e.true_time,e.internal_time,
+                                      e.type,e.uid);
+            continue;
+          }
+        }
+        if(e.type==COMPUTE && d->vm->due(e.internal_time)) {
+          PendingCompute pc = { d, e.internal_time };
+          round.push_back(pc); round_time = e.true_time;
+          continue;
+        }
+      }
       sim_time=e.true_time; // set time to new value
       hardware.set_vm_context(d); // align kernel/sim patch for this device
       d->internal_event(e.internal_time,(DeviceEvent)e.type);
-      if(e.type==COMPUTE) {
-        d->run_time = e.internal_time;
-        SECONDS tt, it;  // true and internal time
-        d->timer->next_compute(&tt,&it); tt+=sim_time; it+=d->run_time;
-	scheduler->schedule_event((void*)id,tt,it,COMPUTE,d->uid);
-        d->timer->next_transmit(&tt,&it); tt+=sim_time; it+=d->run_time;
-        scheduler->schedule_event((void*)id,tt,it,BROADCAST,d->uid);
-      }
+      if(e.type==COMPUTE) schedule_after_compute(d,e.internal_time);
     }
   }
+  if(!round.empty()) finish_round();
   sim_time=limit;
   
   // clone or kill devices (at end of update period)
@@ -791,6 +1033,85 @@ bool SpatialComputer::evolve(SECONDS limit) {
   return true;
 }
 
+// queue a device's next compute and broadcast; returns the earlier time
+SECONDS SpatialComputer::schedule_after_compute(Device* d, SECONDS internal_time) {
+  d->run_time = internal_time;
+  SECONDS tt, it, first;  // true and internal time
+  d->timer->next_compute(&tt,&it); tt+=sim_time; it+=d->run_time;
+  scheduler->schedule_event((void*)d->backptr,tt,it,COMPUTE,d->uid);
+  first = tt;
+  d->timer->next_transmit(&tt,&it); tt+=sim_time; it+=d->run_time;
+  scheduler->schedule_event((void*)d->backptr,tt,it,BROADCAST,d->uid);
+  return min(first,tt);
+}
+
+// Run the computes gathered for a synchronous round, lockstep_width VMs at
+// a time, and queue what follows them.  Returns the earliest time queued.
+// A device whose script is not lockstep safe runs alone, in its turn.
+SECONDS SpatialComputer::finish_round() {
+  sim_time = round_time;
+  for(int i=0;i<round.size();) {
+    if(!round[i].d->is_lockstep) { // as it would run outside a round
+      hardware.set_vm_context(round[i].d);
+      round[i].d->internal_event(round[i].internal_time,COMPUTE);
+      i++; continue;
+    }
+    int n = 1;
+    while(n<lockstep_width && i+n<round.size() && round[i+n].d->is_lockstep)
+      n++;
+    run_lockstep(&round[i],n);
+    i += n;
+  }
+  SECONDS first = -1;
+  for(int i=0;i<round.size();i++) {
+    SECONDS t = schedule_after_compute(round[i].d,round[i].internal_time);
+    if(first<0 || t<first) first = t;
+  }
+  round.clear();
+  return first;
+}
+
+// The VMs of a group run the same script, so they are stepped together:
+// each instruction is decoded once and executed for every VM that has
+// reached it.  VMs that branch elsewhere wait, and the group always
+// advances the VMs furthest behind in the script, so that they rejoin
+// the others after the branch.
+void SpatialComputer::run_lockstep(PendingCompute* group, int n) {
+  lanes.clear();
+  for(int i=0;i<n;i++) {
+    Device* d = group[i].d;
+    hardware.set_vm_context(d);
+    d->begin_compute(group[i].internal_time);
+    if(!d->vm->finished()) lanes.push_back(d);
+  }
+  Int8 const * lead = NULL;
+  for(int k=0;k<lanes.size();k++) {
+    Int8 const * ip = lanes[k]->vm->instruction_pointer;
+    if(!lead || ip<lead) lead = ip;
+  }
+  while(!lanes.empty()) {
+    Int8 opcode = *lead;
+    Instruction f = instructions[opcode];
+    Int8 const * next_lead = NULL;
+    for(int k=0;k<lanes.size();) {
+      Machine* vm = lanes[k]->vm;
+      if(vm->instruction_pointer==lead) {
+        hardware.set_vm_context(lanes[k]);
+        vm->step(opcode,f);
+        if(vm->finished()) { lanes[k]=lanes.back(); lanes.pop_back(); continue; }
+      }
+      Int8 const * ip = vm->instruction_pointer;
+      if(!next_lead || ip<next_lead) next_lead = ip;
+      k++;
+    }
+    lead = next_lead;
+  }
+  for(int i=0;i<n;i++) {
+    hardware.set_vm_context(group[i].d);
+    group[i].d->end_compute();
+  }
+}
+
 /*****************************************************************************
  *  DUMPING FACILITY                                                         *
  *****************************************************************************/
@@ -813,6 +1134,7 @@ void SpatialComputer::dump_header(FILE* out) {
   for(int i=0;i<dynamics.max_id();i++)
     { Layer* d = (Layer*)dynamics.get(i); if(d) d->dump_header(out); }
   if(is_dump_value) fprintf(out," \"OUT\"");
+  if(is_dump_verified) fprintf(out," \"VERIFIED\"");
   fprintf(out,"\n");
 }
 
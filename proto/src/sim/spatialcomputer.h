@@ -20,6 +20,9 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "sim-hardware.h"
 #include "utils.h"
 #include "scheduler.h"
+#include "native.h"
+#include "verify.h"
+#include "profile.h"
 
 #include "kernelversion.h"
 
@@ -53,6 +56,8 @@ class TimeModel {
  public:
   virtual DeviceTimer* next_timer(SECONDS* start_lag)=0;
   virtual SECONDS cycle_time()=0; // approximate length of cycle
+  // do all devices compute at the same instants?
+  virtual bool is_synchronous() { return false; }
 };
 
 
@@ -83,6 +88,7 @@ class DeviceLayer : public EventConsumer {
   virtual ~DeviceLayer() {}; // make sure destruction cascades correctly
   virtual void preupdate() {}  // to called before computation
   virtual void update() {}  // to called after a computation
+  virtual void exported(Array<Data> const & data) {} // before a broadcast
   virtual void visualize() {} // to be called at visualization
   virtual bool handle_key(KeyEvent* event) { return false; }
   virtual void copy_state(DeviceLayer* src)=0; // to be called during cloning
@@ -124,6 +130,22 @@ class BodyDynamics : public Layer {
  *****************************************************************************/
 enum DeviceEvent { COMPUTE, BROADCAST };
 
+// What a run can read besides its script, for -skip-unchanged: a round that
+// finds these as the last run found them would compute the same again.
+enum { READS_HOOD = 1, READS_RANGE = 2 }; // which inputs a script reads
+struct RoundInputs {
+  bool valid;                       // captured since the script loaded?
+  std::vector<MachineId> ids;       // the fresh neighbours, in hood order
+  std::vector<Number> positions;    // their x, y, z
+  std::vector<Data> imports;        // what they export
+  std::vector<Data> state;          // feedback state
+  Number range;                     // radio range, if READS_RANGE
+  RoundInputs() : valid(false), range(0) {}
+  void capture(Machine* vm, SECONDS time, int reads);
+  bool same_as(RoundInputs const & o) const;
+  void swap(RoundInputs & o);
+};
+
 class Device : public EventConsumer {
   static int top_uid;               // uids are generated in rising sequence
  public:
@@ -135,23 +157,42 @@ class Device : public EventConsumer {
   DeviceLayer** layers;             // integration with dynamics
   //MACHINE* vm;                    // the Proto kernel
   Machine * vm;                     // the DelftProto Virtual Machine
+  NativeRun native_run;             // its script compiled (-native), or NULL
+  bool is_verified;                 // is its script bounded (see verify.h)?
+  bool is_lockstep;                 // may its runs be stepped in lockstep?
+  int round_reads;                  // -skip-unchanged: what its runs read,
+                                    // or 0 if rounds can't be skipped
+  RoundInputs last_inputs, inputs;  // as of the last run, and of this round
   SpatialComputer* parent;          // upward track for the device
   bool is_selected;                 // is this device currently selected?
   bool is_debug;                    // is this device currently a debug focus?
   bool is_print_stack;              // are we printing the stack of this device to cout after each instruction?
   bool is_print_env_stack;          // are we printing the env stack
+  // delta exports (-delta-exports): what was last sent, what changed since
+  Array<Data> last_export;          // export as of the previous broadcast
+  std::vector<bool> export_changed; // slots differing from last_export
+  bool export_is_delta;             // is the coming broadcast a delta?
+  int exports_since_full;           // deltas sent since the last refresh
+  uint8_t export_seq;               // numbers broadcasts, to match deltas
   
   Device(SpatialComputer* parent, METERS *loc, DeviceTimer *timer);
   ~Device();
   Device* clone_device(METERS *loc); // make a clone at location loc
   void internal_event(SECONDS time, DeviceEvent type); // broadcast or compute
+  void begin_compute(SECONDS time); // a compute is these, around the VM run
+  void end_compute();
+  void start_run(SECONDS time);     // the run of the next thread due
   void text_scale();                // scale to display text about device
-  void load_script(uint8_t const * script, int len);
+  void load_script(uint8_t const * script, int len,
+                   Machine const * installed = NULL); // copied, if given
   bool handle_key(KeyEvent* key);
   virtual void visualize();
   virtual void render_selection(); // render for selection
   virtual void dump_state(FILE* out, int verbosity);
   bool debug();
+ private:
+  void mark_export_changes();       // fill export_changed before broadcast
+  bool inputs_unchanged(SECONDS time); // may this round's run be skipped?
 };
 
 // a request for cloning carries info about location and source, too
@@ -169,7 +210,8 @@ class SpatialComputer : public EventConsumer {
  public:
   // display variables
   bool is_show_val, is_show_vec, is_show_id, is_show_version;
-  bool is_debug, is_dump_default, is_dump_hood, is_dump_value; 
+  bool is_debug, is_dump_default, is_dump_hood, is_dump_value;
+  bool is_dump_verified; 
   int print_stack_id, print_env_stack_id; // id of device to print stack of
   flo display_mag; // magnifier for body display
   Population selection;     // the list of devices currently selected
@@ -192,6 +234,16 @@ class SpatialComputer : public EventConsumer {
   Scheduler* scheduler;     // "priority queue" for device events
   SimulatedHardware hardware; // patch connecting VMs and dynamics
   int version;              // what software version is currently running
+  int delta_refresh;        // delta exports: full export every N (0 = off)
+  int hood_timeout;         // rounds unheard before a neighbour expires
+  SECONDS hood_timeout_secs; // or seconds, if positive
+  int lockstep_width;       // VMs stepped together in a synchronous round
+  NativeCompiler* native;   // compiles scripts as they load, if -native
+  Profiler* profile;        // counts the instructions run, if -profile
+  bool is_verify;           // verify scripts before loading them?
+  bool is_skip_unchanged;   // skip runs whose inputs are those of the last
+  bool is_install_alike;    // does the script install alike on all devices?
+  std::map<std::string,ScriptBounds> verified; // by script content
 
   std::queue<int> death_q;  // nodes requesting to suicide
   std::queue<CloneReq*> clone_q;  // nodes requesting to reproduce
@@ -201,6 +253,7 @@ class SpatialComputer : public EventConsumer {
   ~SpatialComputer();
   void load_script(uint8_t* script, int len);
   void load_script_at_selection(uint8_t* script, int len);
+  ScriptBounds const * verify(uint8_t const * script, int len);
   // EventConsumer routines
   bool handle_key(KeyEvent* key);
   bool handle_mouse(MouseEvent* mouse);
@@ -218,6 +271,7 @@ class SpatialComputer : public EventConsumer {
   // configuration routines
   bool is_3d() { return volume->dimensions()>2; }
   void appendDefops(std::string& s);
+  int addLayer(Layer* layer); // add a layer to dynamics & set callback vars
 
   virtual void register_colors();
   static Color *BACKGROUND, *PHOTO_FLASH, *DEVICE_SELECTED, *DEVICE_DEBUG,
@@ -226,8 +280,15 @@ class SpatialComputer : public EventConsumer {
  private:
   void initialize_plugins(Args* args, int n);
   void get_volume(Args* args, int n); // shared dist constructor
-  int addLayer(Layer* layer); // add a layer to dynamics & set callback vars
   int addLayer(const char* layer,Args* args,int n);// add layer from plugin
+  // lockstep execution of synchronous rounds
+  struct PendingCompute { Device* d; SECONDS internal_time; };
+  std::vector<PendingCompute> round;  // computes gathered at round_time
+  SECONDS round_time;
+  std::vector<Device*> lanes;         // VMs still running in a group
+  SECONDS finish_round();
+  void run_lockstep(PendingCompute* group, int n);
+  SECONDS schedule_after_compute(Device* d, SECONDS internal_time);
 };
 
 // global variable set to the spatial computer during visualize(),
@@ -0,0 +1,82 @@
+/* Spatial index for radio neighborhood queries
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors 
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include "spatialindex.h"
+#include <math.h>
+
+using namespace std;
+
+CellIndex::CellIndex(const Rect* volume, METERS cell_size) {
+  size = cell_size; dims = volume->dimensions();
+  cell_left = volume->l; cell_bottom = volume->b;
+  if(size<=0) { // unindexed: a single cell holds everything
+    rows = cols = lvls = 1; cell_floor = 0;
+  } else {
+    rows = max(1,(int)ceil((volume->r-volume->l)/size));
+    cols = max(1,(int)ceil((volume->t-volume->b)/size));
+    if(dims==3) {
+      const Rect3* v3 = (const Rect3*)volume;
+      cell_floor = v3->f; lvls = max(1,(int)ceil((v3->c-v3->f)/size));
+    } else {
+      cell_floor = 0; lvls = 1;
+    }
+  }
+  dense.resize(rows*cols*lvls);
+  for(int i=0;i<dense.size();i++) {
+    dense[i] = new Cell(); dense[i]->outside = false; dense[i]->id = i;
+  }
+  next_id = dense.size();
+}
+
+CellIndex::~CellIndex() {
+  for(int i=0;i<dense.size();i++) delete dense[i];
+  for(map<Coord,Cell*>::iterator i=overflow.begin();i!=overflow.end();i++)
+    delete i->second;
+}
+
+CellIndex::Coord CellIndex::coord(const flo* p) const {
+  Coord c;
+  if(size<=0) { c.x = c.y = c.z = 0; return c; }
+  c.x = (int)floor((p[0]-cell_left)/size);
+  c.y = (int)floor((p[1]-cell_bottom)/size);
+  c.z = (dims==3) ? (int)floor((p[2]-cell_floor)/size) : 0;
+  return c;
+}
+
+CellIndex::Cell* CellIndex::cell(const Coord& c, bool create) {
+  if(c.x>=0 && c.x<rows && c.y>=0 && c.y<cols && c.z>=0 && c.z<lvls)
+    return dense[(c.z*rows + c.x)*cols + c.y];
+  map<Coord,Cell*>::iterator i = overflow.find(c);
+  if(i!=overflow.end()) return i->second;
+  if(!create) return NULL;
+  Cell* nc = new Cell(); nc->at = c; nc->outside = true; nc->id = next_id++;
+  return overflow[c] = nc;
+}
+
+Population* CellIndex::cell_at(const flo* p) { return cell(coord(p),true); }
+
+void* CellIndex::remove(Population* cell, size_t loc) {
+  Cell* c = (Cell*)cell;
+  void* item = c->remove(loc);
+  if(c->outside && c->size()==0) { overflow.erase(c->at); delete c; }
+  return item;
+}
+
+void CellIndex::cells_near(const flo* p, METERS radius,
+                           vector<Population*>* out) {
+  Coord c = coord(p), n;
+  int reach = (size<=0) ? 0 : max(1,(int)ceil(radius/size));
+  int zreach = (dims==3) ? reach : 0;
+  for(n.x=c.x-reach;n.x<=c.x+reach;n.x++)
+    for(n.y=c.y-reach;n.y<=c.y+reach;n.y++)
+      for(n.z=c.z-zreach;n.z<=c.z+zreach;n.z++) {
+        Population* cp = cell(n,false);
+        if(cp && cp->size()) out->push_back(cp);
+      }
+}
@@ -0,0 +1,66 @@
+/* Spatial index for radio neighborhood queries
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors 
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __SPATIALINDEX__
+#define __SPATIALINDEX__
+
+#include <map>
+#include <vector>
+#include "utils.h"
+
+/**
+ * Buckets items (typically Device pointers) into cubic cells of a fixed
+ * size.  Cells covering the simulation volume are stored densely; cells
+ * outside it are created on demand, so items that drift out of the volume
+ * still get local queries instead of piling into a few border cells.
+ * Those outside cells are destroyed again when remove() empties them, so
+ * a Population* returned by cell_at() is a handle only while it holds
+ * something.  A cell_size of 0 puts everything into one cell, which turns
+ * every query into an exhaustive search (for checking the index).
+ */
+class CellIndex {
+ public:
+  CellIndex(const Rect* volume, METERS cell_size);
+  ~CellIndex();
+  METERS cell_size() const { return size; }
+
+  /// the cell containing point p, created if needed
+  Population* cell_at(const flo* p);
+  /// all existing non-empty cells within radius of p's cell
+  void cells_near(const flo* p, METERS radius, std::vector<Population*>* out);
+  /// take the item at loc out of cell, destroying the cell if it is
+  /// outside the volume and now empty; returns the item
+  void* remove(Population* cell, size_t loc);
+  /// stable number of a cell: dense cells count up from 0, outside cells
+  /// continue from there in order of creation
+  int cell_id(const Population* cell) const { return ((const Cell*)cell)->id; }
+  /// number of cells currently held outside the volume
+  int overflow_cells() const { return overflow.size(); }
+
+ private:
+  struct Coord {
+    int x, y, z;
+    bool operator<(const Coord& o) const {
+      return x!=o.x ? x<o.x : (y!=o.y ? y<o.y : z<o.z);
+    }
+  };
+  struct Cell : public Population {
+    Coord at; bool outside; int id;
+  };
+  METERS size, cell_left, cell_bottom, cell_floor;
+  int rows, cols, lvls, dims, next_id;
+  std::vector<Cell*> dense;
+  std::map<Coord,Cell*> overflow;
+
+  Coord coord(const flo* p) const;
+  Cell* cell(const Coord& c, bool create);
+
+  DISALLOW_COPY_AND_ASSIGN(CellIndex);
+};
+
+#endif // __SPATIALINDEX__
@@ -68,6 +68,12 @@ class BasicStack {
          stackVector.push_back(element);
 		}
 		
+		/// Push a default-constructed element on the stack, to be filled in place.
+		inline Element & emplace() {
+         stackVector.push_back(Element());
+         return stackVector.back();
+		}
+		
 		/// Pop an element from the stack.
 		inline Element pop() {
          Element ret = stackVector[size()-1];
@@ -77,8 +83,7 @@ class BasicStack {
 		
 		/// Remove multiple elements from the stack.
 		inline void pop(Size elements) {
-         //stackVector.erase(stackVector.end(), stackVector.end()+elements);
-         for(Int i=0; i<(Int)elements; ++i) pop();
+         stackVector.resize(size()-elements);
 		}
 		
 		/// Access an element by its offset from the top of the stack.
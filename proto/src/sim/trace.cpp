@@ -0,0 +1,196 @@
+/* Binary traces of what the VMs see, for replaying them without a simulator
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include <string.h>
+#include <map>
+#include "trace.h"
+#include "utils.h"
+
+#define TRACE_WINDOW 8 // stack entries watched across a platform op
+
+bool same_data(Data const & a, Data const & b) {
+  if(a.type()!=b.type()) return false;
+  switch(a.type()) {
+  case Data::Type_number: return a.asNumber()==b.asNumber();
+  case Data::Type_address: return (Int8 const*)a.asAddress()==(Int8 const*)b.asAddress();
+  case Data::Type_tuple: {
+    Tuple const & ta = a.asTuple(), & tb = b.asTuple();
+    if(ta.size()!=tb.size()) return false;
+    for(Index i = 0; i < ta.size(); i++)
+      if(!same_data(ta[i],tb[i])) return false;
+    return true;
+  }
+  default: return true;
+  }
+}
+
+/*****************************************************************************
+ *  WRITING                                                                  *
+ *****************************************************************************/
+TraceWriter::TraceWriter(const char* filename, int hood_timeout,
+                         Time hood_timeout_secs) {
+  out = fopen(filename,"wb");
+  if(!out) uerror("Couldn't open trace file %s",filename);
+  fwrite(TRACE_MAGIC,1,strlen(TRACE_MAGIC),out);
+  put((int32_t)hood_timeout); put(hood_timeout_secs);
+  vm = NULL; before_size = 0;
+}
+
+TraceWriter::~TraceWriter() { fclose(out); }
+
+void TraceWriter::put_data(Data const & d, Int8 const * base) {
+  put((uint8_t)d.type());
+  switch(d.type()) {
+  case Data::Type_number: put(d.asNumber()); break;
+  case Data::Type_address:
+    put((int32_t)((Int8 const*)d.asAddress() - base)); break;
+  case Data::Type_tuple: {
+    Tuple const & t = d.asTuple();
+    put((uint16_t)t.size());
+    for(Index i = 0; i < t.size(); i++) put_data(t[i],base);
+    break;
+  }
+  default: break;
+  }
+}
+
+void TraceWriter::load(Machine* vm, Int8 const * script, Size len) {
+  int n = 0; // scripts are few, so a linear search for repeats is fine
+  while(n < scripts.size() && !(scripts[n].size()==len &&
+        (len==0 || !memcmp(&scripts[n][0],script,len)))) n++;
+  if(n==scripts.size()) {
+    scripts.push_back(vector<Int8>(script,script+len));
+    put((char)TRACE_SCRIPT); put((uint32_t)len); fwrite(script,1,len,out);
+  }
+  put((char)TRACE_LOAD); put((int32_t)vm->id); put((int32_t)n);
+}
+
+void TraceWriter::compute(Machine* vm, Time time) {
+  Int8 const * base = vm->currentScript();
+  put((char)TRACE_COMPUTE); put((int32_t)vm->id); put((uint32_t)vm->rounds);
+  put(time); put((uint32_t)(vm->hood.size() ? vm->hood.size()-1 : 0));
+  NeighbourHood::iterator i = vm->hood.begin();
+  if(i != vm->hood.end()) i++; // skip self, which the replay keeps itself
+  for(; i != vm->hood.end(); i++) {
+    put((int32_t)i->id); put((uint32_t)i->heard_round); put(i->heard_time);
+    put(i->x); put(i->y); put(i->z); put(i->lag);
+    put((uint16_t)i->imports.size());
+    for(Size j = 0; j < i->imports.size(); j++) put_data(i->imports[j],base);
+  }
+}
+
+void TraceWriter::before_op(Machine* vm) {
+  this->vm = vm; before_size = vm->stack.size();
+  before.clear();
+  for(Size i = before_size > TRACE_WINDOW ? before_size-TRACE_WINDOW : 0;
+      i < before_size; i++)
+    before.push_back(vm->stack[i]);
+}
+
+// An op's effect is taken to be: pop down to the lowest watched entry that
+// changed, then push everything above it.
+void TraceWriter::after_op() {
+  Size after_size = vm->stack.size();
+  Size lo = before_size - before.size(), q = min(before_size,after_size);
+  for(Size i = lo; i < q; i++)
+    if(!same_data(vm->stack[i],before[i-lo])) { q = i; break; }
+  put((char)TRACE_SENSOR); put((uint16_t)(before_size-q));
+  put((uint16_t)(after_size-q));
+  for(Size i = q; i < after_size; i++)
+    put_data(vm->stack[i],vm->currentScript());
+  vm = NULL;
+}
+
+void TraceWriter::reading(Number value) {
+  put((char)TRACE_SENSOR); put((uint16_t)0); put((uint16_t)1);
+  put((uint8_t)Data::Type_number); put(value);
+}
+
+/*****************************************************************************
+ *  READING                                                                  *
+ *****************************************************************************/
+TraceReader::TraceReader(const char* filename) {
+  in = fopen(filename,"rb");
+  if(!in) uerror("Couldn't open trace file %s",filename);
+  char magic[sizeof(TRACE_MAGIC)];
+  if(fread(magic,1,strlen(TRACE_MAGIC),in)!=strlen(TRACE_MAGIC) ||
+     strncmp(magic,TRACE_MAGIC,strlen(TRACE_MAGIC)))
+    uerror("%s is not a trace file",filename);
+  hood_timeout = get<int32_t>(); hood_timeout_secs = get<Time>();
+  map<MachineId,int> loaded; // the script each device is running
+  int c;
+  while((c = fgetc(in)) != EOF) {
+    switch(c) {
+    case TRACE_SCRIPT: {
+      Size len = get<uint32_t>();
+      Int8* s = new Int8[len];
+      if(fread(s,1,len,in)!=len) truncated();
+      scripts.push_back(s); script_sizes.push_back(len);
+      break;
+    }
+    case TRACE_LOAD: {
+      events.push_back(TraceEvent()); TraceEvent & e = events.back();
+      e.type = TRACE_LOAD; e.uid = get<int32_t>(); e.script = get<int32_t>();
+      if(e.script < 0 || e.script >= scripts.size()) truncated();
+      loaded[e.uid] = e.script;
+      break;
+    }
+    case TRACE_COMPUTE: {
+      events.push_back(TraceEvent()); TraceEvent & e = events.back();
+      e.type = TRACE_COMPUTE; e.uid = get<int32_t>();
+      e.rounds = get<uint32_t>(); e.time = get<Time>();
+      if(!loaded.count(e.uid)) truncated();
+      Int8 const * base = scripts[loaded[e.uid]];
+      e.hood.resize(get<uint32_t>());
+      for(Size i = 0; i < e.hood.size(); i++) {
+        TraceNeighbour & n = e.hood[i];
+        n.id = get<int32_t>(); n.heard_round = get<uint32_t>();
+        n.heard_time = get<Time>();
+        n.x = get<Number>(); n.y = get<Number>(); n.z = get<Number>();
+        n.lag = get<Number>();
+        n.imports.reset(get<uint16_t>());
+        for(Size j = 0; j < n.imports.size(); j++) n.imports[j] = get_data(base);
+      }
+      break;
+    }
+    case TRACE_SENSOR: {
+      if(events.empty()) truncated();
+      TraceEvent & e = events.back();
+      Int8 const * base = scripts[loaded[e.uid]];
+      e.readings.push_back(TraceReading()); TraceReading & r = e.readings.back();
+      r.pops = get<uint16_t>();
+      r.values.resize(get<uint16_t>());
+      for(Size i = 0; i < r.values.size(); i++) r.values[i] = get_data(base);
+      break;
+    }
+    default: truncated();
+    }
+  }
+  fclose(in);
+}
+
+TraceReader::~TraceReader() {
+  for(int i=0;i<scripts.size();i++) delete[] scripts[i];
+}
+
+Data TraceReader::get_data(Int8 const * base) {
+  switch(get<uint8_t>()) {
+  case Data::Type_number: return Data(get<Number>());
+  case Data::Type_address: return Data(Address(base + get<int32_t>()));
+  case Data::Type_tuple: {
+    Size n = get<uint16_t>();
+    Tuple t(n);
+    for(Size i = 0; i < n; i++) t.push(get_data(base));
+    return Data(t);
+  }
+  default: return Data();
+  }
+}
+
+void TraceReader::truncated() { uerror("Trace file is truncated or corrupt"); }
@@ -0,0 +1,93 @@
+/* Binary traces of what the VMs see, for replaying them without a simulator
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __TRACE__
+#define __TRACE__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <machine.hpp>
+using namespace std;
+
+// A trace (-record-trace FILE) is a header of magic, hood timeout in
+// rounds and in seconds, then a stream of tagged records:
+//   'P' len bytes          a script, written the first time it is loaded
+//   'L' uid script         a device installs a script (by order of 'P')
+//   'C' uid rounds time n  a compute starts, with the n neighbours other
+//                          than the device itself, as the radio left them
+//   'S' pops k             a sensor or platform op ran: it popped this many
+//                          values from the stack, then pushed k values
+// A neighbour is its id, heard round and time, x y z, lag and imports.
+// Data are a type byte followed by a float (numbers), an offset into the
+// script (addresses) or a length and elements (tuples).  All values are
+// written in host byte order.
+#define TRACE_MAGIC "PTRC1"
+enum { TRACE_SCRIPT='P', TRACE_LOAD='L', TRACE_COMPUTE='C', TRACE_SENSOR='S' };
+
+// deep comparison, since Data has no operator==
+bool same_data(Data const & a, Data const & b);
+
+class TraceWriter {
+  FILE* out;
+  vector<vector<Int8> > scripts;  // written so far, in order
+  Machine* vm;                    // machine whose op is running
+  vector<Data> before;            // top of its stack before the op
+  Size before_size;
+ public:
+  TraceWriter(const char* filename, int hood_timeout, Time hood_timeout_secs);
+  ~TraceWriter();
+  void load(Machine* vm, Int8 const * script, Size len);
+  void compute(Machine* vm, Time time);
+  // platform ops are bracketed, so their effect on the stack is recorded
+  void before_op(Machine* vm);
+  void after_op();
+  void reading(Number value); // a sensor read by an instruction
+ private:
+  void put_data(Data const & d, Int8 const * base);
+  template<class T> void put(T const & v) { fwrite(&v,sizeof(T),1,out); }
+};
+
+// A whole trace in memory, ready to be replayed
+struct TraceNeighbour {
+  MachineId id; Counter heard_round; Time heard_time;
+  Number x, y, z, lag;
+  Array<Data> imports;
+};
+
+struct TraceReading {
+  Size pops;
+  vector<Data> values;
+};
+
+struct TraceEvent {
+  char type;                     // TRACE_LOAD or TRACE_COMPUTE
+  MachineId uid;
+  int script;                    // loads: index into TraceReader::scripts
+  Counter rounds; Time time;     // computes
+  vector<TraceNeighbour> hood;   // computes
+  vector<TraceReading> readings; // in the order they were taken
+};
+
+class TraceReader {
+ public:
+  int hood_timeout; Time hood_timeout_secs;
+  vector<Int8*> scripts; vector<Size> script_sizes;
+  vector<TraceEvent> events;
+  TraceReader(const char* filename); // exits with an error on a bad trace
+  ~TraceReader();
+ private:
+  FILE* in;
+  Data get_data(Int8 const * base);
+  template<class T> T get() {
+    T v; if(fread(&v,sizeof(T),1,in)!=1) truncated(); return v;
+  }
+  void truncated();
+};
+
+#endif // __TRACE__
@@ -36,6 +36,7 @@ UnitDiscRadio::UnitDiscRadio(Args* args, SpatialComputer* p, int n) : RadioSim(a
   is_show_logical_nbrs = args->extract_switch("-lc");
   is_show_radio = args->extract_switch("-show-radio");
   is_fast_prune_hood = !args->extract_switch("-no-motion-pruning");
+  is_cell_index = !args->extract_switch("-no-radio-index");
   is_debug_radio = args->extract_switch("-debug-radio");
   args->undefault(&can_dump,"-Dradio","-NDradio");
   // register hardware patches
@@ -49,35 +50,20 @@ UnitDiscRadio::UnitDiscRadio(Args* args, SpatialComputer* p, int n) : RadioSim(a
 }
 
 void UnitDiscRadio::create_cell_representation() {
-  SpatialComputer* p = parent;
-  // make internal space representation, starting with grid size
-  cell_rows = (int)ceil((p->volume->r-p->volume->l)/range)+2;
-  cell_cols = (int)ceil((p->volume->t-p->volume->b)/range)+2;
-  cell_lvls = (p->volume->dimensions()==2)?1:
-    (int)ceil((((Rect3*)p->volume)->c-(((Rect3*)p->volume)->f))/range)+2;
-  // pre-calculate bounds
-  cell_left = p->volume->l-range; cell_bottom = p->volume->b-range;
-  cell_floor = (p->volume->dimensions()==2)?1:
-    ((Rect3*)p->volume)->f-range;
-  lvl_size = cell_rows*cell_cols; num_cells = lvl_size*cell_lvls;
-  // make and populate the cell table
-  cells = (Population**)calloc(num_cells,sizeof(Population*));
-  for(int i=0;i<num_cells;i++) cells[i] = new Population();
+  cells = new CellIndex(parent->volume,is_cell_index ? range : 0);
 }
 
 void UnitDiscRadio::change_radio_range(float newrange) {
   range = newrange; r_sqr = range*range;
-  // Get rid of old cell representation
-  for(int i=0;i<num_cells;i++) { delete cells[i]; }
-  free(cells); 
-  // Replace with new representation
+  // Replace old cell representation with a new one
+  delete cells;
   create_cell_representation();
   // Fill new cells with all devices
   for(int i=0;i<parent->devices.size();i++) {
     Device* d = (Device*)parent->devices.get(i); if(d==NULL) continue;
     UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
-    int c = udd->cell_id = device_cell(d);
-    udd->cell_loc = cells[c]->add(d);
+    udd->cell = cells->cell_at(d->body->position());
+    udd->cell_loc = udd->cell->add(d);
   }
 }
 
@@ -103,8 +89,7 @@ vector<HardwareFunction> UnitDiscRadio::getImplementedHardwareFunctions()
 }
 
 UnitDiscRadio::~UnitDiscRadio() {
-  for(int i=0;i<num_cells;i++) delete cells[i]; // populations assumed empty
-  free(cells);
+  delete cells; // populations assumed empty
 }
 
 bool UnitDiscRadio::handle_key(KeyEvent* key) {
@@ -125,21 +110,6 @@ bool UnitDiscRadio::handle_key(KeyEvent* key) {
   return RadioSim::handle_key(key);
 }
 
-// calculate which internal storage cell contains a device
-int UnitDiscRadio::device_cell(Device* d) {
-  const flo* p = d->body->position();
-  int row = (int)floor((p[0]-cell_left)/range);
-  int col = (int)floor((p[1]-cell_bottom)/range);
-  row = BOUND(row,0,cell_rows-1); col = BOUND(col,0,cell_cols-1);
-  int n = row*cell_cols + col;
-  if(cell_lvls>1) { // 3D
-    int lvl = (int)floor((p[2]-cell_floor)/range);
-    lvl = BOUND(lvl,0,cell_lvls-1);
-    n += lvl_size*lvl;
-  }
-  return n;
-}
-
 // squared distance between two points
 flo range3sqr(const flo* a, const flo* b) {
   flo dx = a[0]-b[0], dy = a[1]-b[1], dz = a[2]-b[2];
@@ -157,9 +127,7 @@ struct NbrRecord {
 };
 
 // handle the actual connections of a device into a cell
-void UnitDiscRadio::connect_to_cell(Device* d,int cell_id) {
-  if(cell_id<0 || cell_id>=num_cells) return; // bounds check
-  Population* c = cells[cell_id];
+void UnitDiscRadio::connect_to_cell(Device* d,Population* c) {
   UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
   const flo* p = d->body->position();
   bool debug = is_debug_radio && d->debug();
@@ -182,42 +150,29 @@ void UnitDiscRadio::connect_to_cell(Device* d,int cell_id) {
     }
   }
 }
-// connect a device to its 2D-adjacent cells
-// Note that this will check for connections wrapping around the edge
-// of the world, but that should not greatly increase cost unless many
-// nodes are outside the original boundaries
-void UnitDiscRadio::connect_device2(Device* d, int base) { 
+
+// connect a device to every device in range, checking only the cells
+// adjacent to its own
+void UnitDiscRadio::connect_device(Device* d) {
+  UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
   bool debug = is_debug_radio && d->debug();
   const flo* p = d->body->position();
-  if(debug) post("id=%d Pos=[%f,%f,%f], in cell %d [of %d x %d x %d] , check:",
-                 base,cell_rows,cell_cols,cell_lvls,d->uid,p[0],p[1],p[2]);
-  for(int i=-cell_cols;i<=cell_cols;i+=cell_cols)
-    for(int j=-1;j<=1;j++) {
-      if(debug) post("cell %d\n",base+i+j);
-      connect_to_cell(d,base+i+j);
-    }
+  if(debug) post("Device %d Pos=[%f,%f,%f]\n",d->uid,p[0],p[1],p[2]);
+  // find neighbors
+  vector<Population*> near;
+  cells->cells_near(p,range,&near);
+  for(int i=0;i<near.size();i++) connect_to_cell(d,near[i]);
   if(debug) {
     post("Final nbr collection:");
-    UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
     for(int i=0;i<udd->neighbors.max_id();i++) {
       NbrRecord* nr = (NbrRecord*)udd->neighbors.get(i);
       if(nr) { post(" %d",nr->nbr->container->uid); }
     }
     post("\n");
   }
-}
-
-void UnitDiscRadio::connect_device(Device* d) {
-  UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
-  int c = udd->cell_id = device_cell(d);
-  // find neighbors
-  connect_device2(d,c);
-  if(cell_lvls>1) { // 3D
-    if(c-lvl_size>=0) connect_device2(d,c-lvl_size);
-    if(c+lvl_size<num_cells) connect_device2(d,c+lvl_size);
-  }
   // insert into cell
-  udd->cell_loc = cells[c]->add(d);
+  udd->cell = cells->cell_at(p);
+  udd->cell_loc = udd->cell->add(d);
 }
 void UnitDiscRadio::disconnect_device(Device *d) {
   UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
@@ -233,7 +188,7 @@ void UnitDiscRadio::disconnect_device(Device *d) {
   }
   // purge local lists & remove from cell
   udd->neighbors.clear();
-  Device* removed = (Device*)cells[udd->cell_id]->remove(udd->cell_loc);
+  Device* removed = (Device*)cells->remove(udd->cell,udd->cell_loc);
   if(removed!=d) { debug("Bad back cell reference!\n"); }
 }
 
@@ -301,6 +256,7 @@ int UnitDiscRadio::radio_send_export (uint8_t version, Array<Data> const & data)
 
   // cache data
   int src_id = device->uid;
+  vector<bool> const * changed = delta_of(device);
   // walk neighbors
   UnitDiscDevice* udd = (UnitDiscDevice*)device->layers[id];
   for(int i=0;i<udd->neighbors.max_id();i++) {
@@ -309,15 +265,29 @@ int UnitDiscRadio::radio_send_export (uint8_t version, Array<Data> const & data)
       // hardware->set_vm_context(nr->nbr->container);
       /*radio_receive_export(src_id, version, timeout, -nr->dp[0], -nr->dp[1],
                            -nr->dp[2], n, buf);*/
-      Neighbour & nbr = nr->nbr->container->vm->hood[src_id];
-      for(Size i = 0; i < data.size(); i++) nbr.imports[i] = data[i];
-      nbr.x = -nr->dp[0];
-      nbr.y = -nr->dp[1];
-      nbr.z = -nr->dp[2];
-      nbr.data_age = 0;
+      Neighbour* nbr =
+        receive_export(nr->nbr->container->vm,src_id,version,data,changed);
+      if(!nbr) continue; // delta without a fresh base
+      nbr->x = -nr->dp[0];
+      nbr->y = -nr->dp[1];
+      nbr->z = -nr->dp[2];
     }
   }
   // hardware->set_vm_context(udd->container); // restore context
+  return 1;
+}
+
+bool UnitDiscRadio::list_receivers(vector<Reception>* out) {
+  UnitDiscDevice* udd = (UnitDiscDevice*)device->layers[id];
+  for(int i=0;i<udd->neighbors.max_id();i++) {
+    NbrRecord* nr = (NbrRecord*)udd->neighbors.get(i);
+    if(nr) {
+      Reception r; r.rx = nr->nbr->container;
+      for(int j=0;j<3;j++) r.dp[j] = -nr->dp[j];
+      out->push_back(r);
+    }
+  }
+  return true;
 }
 
 int UnitDiscRadio::radio_send_script_pkt (uint8_t version, uint16_t n, 
@@ -383,7 +353,7 @@ void UnitDiscDevice::visualize() {
     container->text_scale(); // prepare to draw text
     char buf[20];
     glTranslatef(0, -1, 0);
-    sprintf(buf, "%2d", parent->device_cell(container));
+    sprintf(buf, "%2d", parent->cells->cell_id(cell));
     palette->use_color(UnitDiscRadio::RADIO_CELL_INFO);
     draw_text(2, 2, buf);
     glPopMatrix();
@@ -410,7 +380,7 @@ void UnitDiscDevice::visualize() {
       palette->use_color(UnitDiscRadio::NET_CONNECTION_SHARP);
       glLineWidth(1);
     } else {
-      if(parent->cell_lvls>1) {
+      if(parent->parent->volume->dimensions()==3) {
         palette->scale_color(UnitDiscRadio::NET_CONNECTION_FUZZY,1,1,1,0.1);
       } else {
         palette->use_color(UnitDiscRadio::NET_CONNECTION_FUZZY);
@@ -436,8 +406,9 @@ void UnitDiscDevice::visualize() {
     glBegin(GL_LINES);
     Machine * m = container->vm;
     for(NeighbourHood::iterator i = m->hood.begin(); i != m->hood.end(); i++){
+    	if (m->expired(*i)) continue;
     	glVertex3f(0,0,0);
-    	glVertex3f(i->x, i->y, i->z);
+    	glVertex3f(Number_toDouble(i->x), Number_toDouble(i->y), Number_toDouble(i->z));
     }
     glLineWidth(1);
     glEnd();
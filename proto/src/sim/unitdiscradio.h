@@ -11,6 +11,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 
 #include "spatialcomputer.h"
 #include "radio.h"
+#include "spatialindex.h"
 
 class UnitDiscRadio : public RadioSim {
  public:
@@ -21,6 +22,7 @@ class UnitDiscRadio : public RadioSim {
   bool is_show_radio;
   bool is_debug_radio;      // turn on radio debugging
   bool is_fast_prune_hood;  // prune the VM neighborhood on movement?
+  bool is_cell_index;       // bucket devices into cells? (off: check all)
   
  public:
   UnitDiscRadio(Args* args, SpatialComputer* parent, int n);
@@ -36,21 +38,17 @@ class UnitDiscRadio : public RadioSim {
 			     uint8_t pkt_num, uint8_t *script);
   int radio_send_digest (uint8_t version, uint16_t script_len, 
 			 uint8_t *digest);
+  bool list_receivers(vector<Reception>* out);
   
   // returns a list of function  that it patches/ provides impementation for
   static vector<HardwareFunction> getImplementedHardwareFunctions();
 
   friend class UnitDiscDevice;
  protected:
-  // storage: gridded in range-size squares to cover screen
-  // an additional layer of cells coats the edges, covering all outside area
-  // it performs badly when devices are not well dispersed in the screen area
-  Population** cells; // collections of Device pointers
-  int cell_rows, cell_cols, cell_lvls, num_cells, lvl_size;
-  METERS cell_left, cell_bottom, cell_floor;
-  int device_cell(Device* d); // which cell is a device in?
-  void connect_to_cell(Device* d,int cell_id); // handle connections
-  void connect_device2(Device* d, int base); // iterate connection over 9 cells
+  // storage: gridded in range-size cells covering the volume; cells
+  // outside it are added as devices wander there
+  CellIndex* cells; // cells are collections of Device pointers
+  void connect_to_cell(Device* d,Population* cell); // handle connections
   void connect_device(Device *d); // create all connections
   void disconnect_device(Device *d); // delete all connections
 
@@ -66,7 +64,7 @@ class UnitDiscDevice : public DeviceLayer {
   UnitDiscRadio* parent;
   // these values are actually managed by the UnitDiscRadio
   Population neighbors; // collection of NbrRecord* (internal definition)
-  int cell_id; // which cell the device was last in (before motion)
+  Population* cell; // which cell the device was last in (before motion)
   int cell_loc; // where is the device in its cell's list
 
   UnitDiscDevice(UnitDiscRadio* parent, Device* container);
@@ -0,0 +1,590 @@
+/* Static verification of scripts before they are installed
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "verify.h"
+#include "bytecode.h"
+
+namespace {
+  // What is known about a value: one of these or, if not negative, the
+  // address of the function with that index.
+  typedef int Type;
+  enum { ANY = -1, NUMBER = -2, TUPLE = -3, ADDRESS = -4 };
+
+  inline bool is_address(Type t) { return t>=0 || t==ADDRESS; }
+
+  Type join(Type a, Type b) {
+    if(a==b) return a;
+    return (is_address(a) && is_address(b)) ? ADDRESS : ANY;
+  }
+
+  // may a value of type t be used where c (as in Effect::pops) is wanted?
+  bool conforms(Type t, char c) {
+    switch(c) {
+    case 'n': return t==ANY || t==NUMBER;
+    case 't': return t==ANY || t==TUPLE;
+    case 'v': return t==ANY || t==NUMBER || t==TUPLE;
+    case 'a': return t==ANY || is_address(t);
+    default: return true;
+    }
+  }
+
+  const char* describe(Type t) {
+    switch(t) {
+    case ANY: return "anything"; case NUMBER: return "a number";
+    case TUPLE: return "a tuple"; default: return "a function";
+    }
+  }
+
+  const char* describe_wanted(char c) {
+    switch(c) {
+    case 'n': return "a number"; case 't': return "a tuple";
+    case 'v': return "a number or tuple"; default: return "a function";
+    }
+  }
+
+  // Instructions that only pop values and push one.  pops gives the types
+  // they take, deepest first: n number, t tuple, v number or tuple, ? any.
+  // push is what they leave: n or t, ? anything, - nothing, = the deepest
+  // value taken (which these instructions leave in place), j the join of
+  // all but the deepest (MUX), m the join of all, + arithmetic (a number
+  // from numbers, else a tuple).
+  struct Effect { const char* key; const char* pops; char push; };
+  const Effect effects[] = {
+    {"NOP","",'-'}, {"VEC","",'-'}, {"VFIL","",'-'},
+    {"LIT","",'n'}, {"LIT8","",'n'}, {"LIT16","",'n'}, {"LIT_N","",'n'},
+    {"LIT_FLO","",'n'}, {"INF","",'n'}, {"NEG_INF","",'n'}, {"MID","",'n'},
+    {"DT","",'n'}, {"SPEED","",'n'}, {"BEARING","",'n'}, {"AREA","",'n'},
+    {"HOOD_RADIUS","",'n'}, {"INFINITESIMAL","",'n'}, {"DENSITY","",'n'},
+    {"NBR_RANGE","",'n'}, {"NBR_BEARING","",'n'}, {"NBR_LAG","",'n'},
+    {"NUL_TUP","",'t'}, {"FAB_NUM_VEC","",'t'}, {"NBR_VEC","",'t'},
+    {"FAB_VEC","?",'t'},
+    {"RND","vv",'+'}, {"ELT","tn",'?'}, {"LEN","v",'n'}, {"ABS","v",'n'},
+    {"NOT","n",'n'}, {"FLOOR","n",'n'}, {"CEIL","n",'n'}, {"ROUND","n",'n'},
+    {"LOG","n",'n'}, {"SQRT","n",'n'}, {"SIN","n",'n'}, {"COS","n",'n'},
+    {"TAN","n",'n'}, {"SINH","n",'n'}, {"COSH","n",'n'}, {"TANH","n",'n'},
+    {"ASIN","n",'n'}, {"ACOS","n",'n'},
+    {"POW","nn",'n'}, {"REM","nn",'n'}, {"MOD","nn",'n'}, {"ATAN2","nn",'n'},
+    {"NUM_ADD","nn",'n'}, {"NUM_SUB","nn",'n'}, {"NUM_MUL","nn",'n'},
+    {"NUM_DIV","nn",'n'}, {"NUM_LT","nn",'n'}, {"NUM_LTE","nn",'n'},
+    {"NUM_GT","nn",'n'}, {"NUM_GTE","nn",'n'}, {"NUM_EQ","nn",'n'},
+    {"NUM_MAX","nn",'n'}, {"NUM_MIN","nn",'n'},
+    {"ADD","vv",'+'}, {"SUB","vv",'+'}, {"MUL","vv",'+'}, {"DIV","vv",'+'},
+    {"EQ","??",'n'}, {"NEQ","??",'n'}, {"LT","??",'n'}, {"LTE","??",'n'},
+    {"GT","??",'n'}, {"GTE","??",'n'}, {"VEQ","??",'n'}, {"VLT","??",'n'},
+    {"VLTE","??",'n'}, {"VGT","??",'n'}, {"VGTE","??",'n'},
+    {"MAX","??",'m'}, {"MIN","??",'m'}, {"VMAX","??",'m'}, {"VMIN","??",'m'},
+    {"MUX","n??",'j'}, {"VMUX","n??",'j'},
+    {"VADD","tt",'t'}, {"VSUB","tt",'t'}, {"VEC_ADD_N","tt",'t'},
+    {"VEC_SUB_N","tt",'t'}, {"VDOT","tt",'n'}, {"DOT","vv",'t'},
+    {"VMUL","nt",'t'}, {"VSLICE","nnt",'t'},
+    {"SET_DT","n",'='}, {"FLEX","n",'='}, {"MOV","t",'='}, {"PROBE","?n",'='},
+    {"ACTIVATE","",'-'}, {"DEACTIVATE","",'-'}, {"TRIGGER","",'-'},
+    {"RESULT","",'?'},
+  };
+
+  Effect const * effect_of(const char* key) {
+    for(int i=0;i<sizeof(effects)/sizeof(effects[0]);i++)
+      if(!strcmp(effects[i].key,key)) return &effects[i];
+    return NULL;
+  }
+
+  inline bool is(const char* key, const char* name) { return !strcmp(key,name); }
+
+  // The stacks before an instruction, relative to the start of its function
+  struct Frame {
+    bool reached;
+    std::vector<Type> stack, lets;
+    Size feedback;             // INIT_FEEDBACKs waiting for their FEEDBACK
+    Frame() : reached(false), feedback(0) {}
+  };
+
+  // A call to a known function, and the depths at which the callee's own
+  // frame starts (the stack includes the return address)
+  struct CallSite {
+    int callee; Size at;
+    Size stack, environment, feedback;
+  };
+
+  struct Function {
+    Size start, end;           // its body, as DEF_FUN gives it
+    Size params;               // environment it reaches below its own lets
+    Size reach;                // and with its callees, which may read the
+                               // lets of the functions that call them
+    Size stack, environment, feedback; // the deepest it goes itself
+    std::vector<CallSite> calls;
+    int totalling;             // 0 not yet, 1 in progress, 2 done
+    Size total_stack, total_environment, total_callbacks, total_feedback;
+  };
+
+  // Results of following one instruction
+  enum { FAILED = -1, STOP = 0, GO_ON = 1 };
+
+  class Verifier {
+    Int8 const * script; Size len;
+    ScriptBounds & bounds;
+    std::vector<Type> globals;
+    std::vector<Function> functions;
+    Function* current;         // being analysed; NULL for installation
+   public:
+    Verifier(Int8 const * script, Size len, ScriptBounds & bounds)
+      : script(script), len(len), bounds(bounds), current(NULL) {}
+    void run();
+   private:
+    int fail(Size at, const char* format, ...);
+    int unbounded(Size at, const char* format, ...);
+    int undecodable(Size at);
+    bool install();
+    bool analyse(Function & f);
+    int execute(Frame & st, DecodedInstruction const & d);
+    int need(Frame & st, Size at, Size n);
+    int call(Size at, Type callee, Size stack, Size environment,
+             Size feedback);
+    int define(Size at, Type t);
+    bool total(int f);
+  };
+
+  void note(std::string & error, Size at, const char* format, va_list ap) {
+    char message[256], where[32];
+    vsnprintf(message,sizeof(message),format,ap);
+    snprintf(where,sizeof(where),"byte %d: ",(int)at);
+    error = std::string(where) + message;
+  }
+
+  int Verifier::fail(Size at, const char* format, ...) {
+    if(bounds.ok) { // the first error is the one reported
+      va_list ap; va_start(ap,format); note(bounds.error,at,format,ap);
+      va_end(ap);
+    }
+    bounds.ok = bounds.bounded = false;
+    return FAILED;
+  }
+
+  int Verifier::unbounded(Size at, const char* format, ...) {
+    if(bounds.bounded) {
+      va_list ap; va_start(ap,format); note(bounds.error,at,format,ap);
+      va_end(ap);
+    }
+    bounds.bounded = false;
+    return STOP;
+  }
+
+  // Platform ops end what can be followed; anything else is malformed.
+  int Verifier::undecodable(Size at) {
+    if(at >= len) return fail(at,"runs off the end of the script");
+    OpcodeInfo const & op = opcode_info(script[at]);
+    if(!op.name)
+      return unbounded(at,"platform opcode %d cannot be followed",script[at]);
+    return fail(at,"%s runs off the end of the script",op.name);
+  }
+
+  int Verifier::need(Frame & st, Size at, Size n) {
+    if(st.stack.size() >= n) return GO_ON;
+    return fail(at,"%s needs %d values but the stack has %d",
+                opcode_info(script[at]).name,(int)n,(int)st.stack.size());
+  }
+
+  // Note a call made by the current function.
+  int Verifier::call(Size at, Type callee, Size stack,
+                     Size environment, Size feedback) {
+    if(!conforms(callee,'a'))
+      return fail(at,"%s calls %s",opcode_info(script[at]).name,
+                  describe(callee));
+    if(!current) return unbounded(at,"the installation code calls a function");
+    if(callee < 0) { unbounded(at,"calls a function it cannot trace"); return GO_ON; }
+    for(Size i = 0; i < current->calls.size(); i++) { // already noted?
+      CallSite const & c = current->calls[i];
+      if(c.at==at && c.callee==callee && c.stack==stack) return GO_ON;
+    }
+    CallSite c = { callee, at, stack, environment, feedback };
+    current->calls.push_back(c);
+    return GO_ON;
+  }
+
+  int Verifier::define(Size at, Type t) {
+    if(current) return unbounded(at,"defines a global as it runs");
+    globals.push_back(t);
+    return GO_ON;
+  }
+
+  // Follow one instruction, updating the stacks in st.
+  int Verifier::execute(Frame & st, DecodedInstruction const & d) {
+    OpcodeInfo const & op = opcode_info(d.opcode);
+    const char* key = op.key; Size at = d.offset;
+    Size n = op.n<0 ? d.operand : op.n; // count of the _N forms and the rest
+    Size depth = st.stack.size(), lets = st.lets.size();
+
+    if(is(key,"ACTIVATE") || is(key,"DEACTIVATE") || is(key,"TRIGGER") ||
+       is(key,"RESULT")) {
+      if((Size)d.operand >= bounds.threads)
+        return fail(at,"%s of thread %d, but there are %d",op.name,
+                    (int)d.operand,(int)bounds.threads);
+    }
+    if(Effect const * e = effect_of(key)) {
+      Size k = strlen(e->pops);
+      if(need(st,at,k)<0) return FAILED;
+      Type taken[3];
+      for(Size i = 0; i < k; i++) {
+        taken[i] = st.stack[depth-k+i];
+        if(!conforms(taken[i],e->pops[i]))
+          return fail(at,"%s is given %s where it needs %s",op.name,
+                      describe(taken[i]),describe_wanted(e->pops[i]));
+      }
+      st.stack.resize(depth-k);
+      switch(e->push) {
+      case '-': break;
+      case 'n': st.stack.push_back(NUMBER); break;
+      case 't': st.stack.push_back(TUPLE); break;
+      case '=': st.stack.push_back(taken[0]); break;
+      case 'j': st.stack.push_back(join(taken[1],taken[2])); break;
+      case 'm': st.stack.push_back(join(taken[0],taken[1])); break;
+      case '+':
+        st.stack.push_back((taken[0]==NUMBER && taken[1]==NUMBER) ? NUMBER :
+                           (taken[0]==TUPLE || taken[1]==TUPLE) ? TUPLE : ANY);
+        break;
+      default: st.stack.push_back(ANY);
+      }
+      return GO_ON;
+    }
+
+    // the environment
+    if(is(key,"REF") || is(key,"REF_N")) {
+      if(n < lets) { st.stack.push_back(st.lets[lets-1-n]); return GO_ON; }
+      if(!current) return fail(at,"REF in the installation code");
+      current->params = std::max(current->params,n-lets+1);
+      st.stack.push_back(ANY);
+      return GO_ON;
+    }
+    if(is(key,"LET") || is(key,"LET_N")) {
+      if(need(st,at,n)<0) return FAILED;
+      st.lets.insert(st.lets.end(),st.stack.end()-n,st.stack.end());
+      st.stack.resize(depth-n);
+      return GO_ON;
+    }
+    if(is(key,"POP_LET") || is(key,"POP_LET_N")) {
+      if(n > lets)
+        return fail(at,"%s with %d values let in its function",op.name,(int)lets);
+      st.lets.resize(lets-n);
+      return GO_ON;
+    }
+    if(is(key,"LET_1_REF_0")) {
+      if(need(st,at,1)<0) return FAILED;
+      st.lets.push_back(st.stack.back());
+      return GO_ON;
+    }
+    if(is(key,"REF_0_POP_LET_1")) {
+      if(!lets) return fail(at,"%s with nothing let in its function",op.name);
+      st.stack.push_back(st.lets.back()); st.lets.pop_back();
+      return GO_ON;
+    }
+
+    // globals and tuples
+    if(is(key,"GLO_REF") || is(key,"GLO_REF_N") || is(key,"GLO_REF16")) {
+      if(n >= globals.size())
+        return fail(at,"%s %d, but there are %d globals",op.name,(int)n,
+                    (int)globals.size());
+      st.stack.push_back(globals[n]);
+      return GO_ON;
+    }
+    if(is(key,"DEF")) {
+      if(need(st,at,1)<0) return FAILED;
+      Type t = st.stack.back(); st.stack.pop_back();
+      return define(at,t);
+    }
+    if(is(key,"DEF_TUP") || is(key,"DEF_VEC")) {
+      Size k = is(key,"DEF_TUP") ? n : 1;
+      if(need(st,at,k)<0) return FAILED;
+      st.stack.resize(depth-k);
+      return define(at,TUPLE);
+    }
+    if(is(key,"DEF_NUM_VEC") || is(key,"DEF_NUM_VEC_N")) return define(at,TUPLE);
+    if(is(key,"FAB_TUP") || is(key,"TUP")) {
+      if(need(st,at,n)<0) return FAILED;
+      st.stack.resize(depth-n); st.stack.push_back(TUPLE);
+      return GO_ON;
+    }
+    if(is(key,"ALL")) {
+      if(need(st,at,std::max(n,(Size)1))<0) return FAILED;
+      Type t = st.stack.back();
+      st.stack.resize(depth-n); st.stack.push_back(t);
+      return GO_ON;
+    }
+
+    // control flow: successors are worked out by the caller
+    if(is(key,"IF") || is(key,"IF16")) {
+      if(need(st,at,1)<0) return FAILED;
+      if(!conforms(st.stack.back(),'n'))
+        return fail(at,"IF on %s",describe(st.stack.back()));
+      st.stack.pop_back();
+      return GO_ON;
+    }
+    if(is(key,"JMP") || is(key,"JMP16")) return GO_ON;
+    if(is(key,"RET")) {
+      if(!current) return fail(at,"RET in the installation code");
+      if(depth!=1)
+        return fail(at,"RET with %d values on the stack",(int)depth);
+      if(lets) return fail(at,"RET with %d values still let",(int)lets);
+      if(st.feedback) return fail(at,"RET before FEEDBACK");
+      return STOP;
+    }
+
+    // calls
+    if(is(key,"FUNCALL") || is(key,"FUNCALL_N")) {
+      if(need(st,at,n+1)<0) return FAILED;
+      if(call(at,st.stack.back(),depth-n+1,lets+n,st.feedback)<=0)
+        return bounds.ok ? STOP : FAILED;
+      st.stack.resize(depth-n-1); st.stack.push_back(ANY);
+      return GO_ON;
+    }
+    if(is(key,"MAP")) {
+      if(need(st,at,2)<0) return FAILED;
+      if(!conforms(st.stack.back(),'t'))
+        return fail(at,"MAP over %s",describe(st.stack.back()));
+      if(call(at,st.stack[depth-2],depth+2,lets+1,st.feedback)<=0)
+        return bounds.ok ? STOP : FAILED;
+      st.stack.resize(depth-2); st.stack.push_back(TUPLE);
+      return GO_ON;
+    }
+    if(is(key,"FOLD") || is(key,"VFOLD")) {
+      if(need(st,at,3)<0) return FAILED;
+      if(!conforms(st.stack.back(),'t'))
+        return fail(at,"%s over %s",op.name,describe(st.stack.back()));
+      if(call(at,st.stack[depth-3],depth+1,lets+2,st.feedback)<=0)
+        return bounds.ok ? STOP : FAILED;
+      st.stack.resize(depth-3); st.stack.push_back(ANY);
+      return GO_ON;
+    }
+    if(is(key,"APPLY")) {
+      if(need(st,at,2)<0) return FAILED;
+      if(!conforms(st.stack[depth-2],'a'))
+        return fail(at,"APPLY calls %s",describe(st.stack[depth-2]));
+      unbounded(at,"APPLY takes its arguments from a tuple");
+      st.stack.resize(depth-2); st.stack.push_back(ANY);
+      return GO_ON;
+    }
+    if(is(key,"FOLD_HOOD") || is(key,"VFOLD_HOOD") ||
+       is(key,"FOLD_HOOD_PLUS") || is(key,"VFOLD_HOOD_PLUS")) {
+      if(need(st,at,3)<0) return FAILED;
+      if(d.operand >= bounds.exports)
+        return fail(at,"%s %d, but there are %d exports",op.name,
+                    (int)d.operand,(int)bounds.exports);
+      if(strstr(key,"PLUS")) { // filter each import, then fuse
+        if(call(at,st.stack[depth-2],depth+1,lets+1,st.feedback)<=0 ||
+           call(at,st.stack[depth-3],depth,lets+2,st.feedback)<=0)
+          return bounds.ok ? STOP : FAILED;
+      } else {
+        if(call(at,st.stack[depth-3],depth-1,lets+2,st.feedback)<=0)
+          return bounds.ok ? STOP : FAILED;
+      }
+      st.stack.resize(depth-3); st.stack.push_back(ANY);
+      return GO_ON;
+    }
+
+    // feedback
+    if(is(key,"INIT_FEEDBACK") || is(key,"FEEDBACK")) {
+      if(d.operand >= bounds.state)
+        return fail(at,"%s %d, but there are %d state variables",op.name,
+                    (int)d.operand,(int)bounds.state);
+      if(is(key,"INIT_FEEDBACK")) {
+        if(need(st,at,1)<0) return FAILED;
+        if(call(at,st.stack.back(),depth+1,lets,st.feedback+1)<=0)
+          return bounds.ok ? STOP : FAILED;
+        st.stack.back() = ANY; st.feedback++;
+      } else {
+        if(need(st,at,2)<0) return FAILED;
+        if(!st.feedback) return fail(at,"FEEDBACK without INIT_FEEDBACK");
+        Type t = st.stack.back();
+        st.stack.resize(depth-2); st.stack.push_back(t); st.feedback--;
+      }
+      return GO_ON;
+    }
+
+    if(is(key,"EXIT")) return fail(at,"EXIT outside the installation code");
+    if(is(key,"DEF_VM") || is(key,"DEF_VM_EX"))
+      return fail(at,"%s after the start of the script",op.name);
+    if(strstr(key,"DEF_FUN")) return unbounded(at,"defines a function as it runs");
+    return unbounded(at,"%s has no known stack effect",op.name);
+  }
+
+  // Run through the installation code, which is straight-line: DEF_VM or
+  // DEF_VM_EX, then the globals, including the functions, then EXIT.
+  bool Verifier::install() {
+    DecodedInstruction d;
+    const char* key = decode_at(script,len,0,d) ? opcode_info(d.opcode).key : "";
+    if(is(key,"DEF_VM")) {
+      bounds.exports = script[2];
+      bounds.globals = (script[3]<<8) | script[4];
+      bounds.state = script[5];
+      bounds.threads = 1;
+    } else if(is(key,"DEF_VM_EX")) {
+      // stack, environment, globals, threads, state, exports, callbacks
+      Int sizes[7]; Size p = 1;
+      for(int i = 0; i < 7; i++) read_int(script,len,p,sizes[i]);
+      bounds.globals = sizes[2]; bounds.threads = sizes[3];
+      bounds.state = sizes[4]; bounds.exports = sizes[5];
+    } else {
+      return fail(0,"the script does not start with DEF_VM or DEF_VM_EX")>0;
+    }
+    Frame st; Size at = d.length;
+    while(true) {
+      if(!decode_at(script,len,at,d)) return undecodable(at)>0;
+      OpcodeInfo const & op = opcode_info(d.opcode);
+      if(is(op.key,"EXIT")) break;
+      if(strstr(op.key,"DEF_FUN")) {
+        if(d.target > len)
+          return fail(at,"%s runs past the end of the script",op.name)>0;
+        Function f = Function();
+        f.start = at + d.length; f.end = d.target;
+        if(f.start == f.end) return fail(at,"an empty function")>0;
+        globals.push_back(functions.size()); functions.push_back(f);
+        at = d.target;
+        continue;
+      }
+      if(op.is_flow)
+        return unbounded(at,"%s in the installation code",op.name)>0;
+      if(execute(st,d)<=0) return false;
+      bounds.stack = std::max(bounds.stack,(Size)st.stack.size());
+      at += d.length;
+    }
+    if(globals.size() > bounds.globals)
+      return fail(at,"%d globals defined, but %s declares %d",
+                  (int)globals.size(),key,(int)bounds.globals)>0;
+    if(bounds.threads < 1 || globals.size() < bounds.threads)
+      return fail(at,"%d threads declared, but there are %d globals to run",
+                  (int)bounds.threads,(int)globals.size())>0;
+    for(Size k = 0; k < bounds.threads; k++) // the last global is thread 0
+      if(globals[globals.size()-1-k] < 0)
+        return fail(at,"thread %d is not a function, so there is nothing "
+                    "to run",(int)k)>0;
+    return true;
+  }
+
+  // Follow every path through a function, checking that paths agree on
+  // the depth of the stacks wherever they meet.
+  bool Verifier::analyse(Function & f) {
+    Size n = f.end - f.start;
+    std::vector<Frame> before(n);
+    std::vector<char> role(n,0); // 1: an instruction starts here, 2: inside
+    std::vector<Size> work(1,f.start);
+    before[0].reached = true;
+    f.params = f.stack = f.environment = f.feedback = 0;
+    while(!work.empty()) {
+      Size at = work.back(); work.pop_back();
+      Frame st = before[at-f.start];
+      DecodedInstruction d;
+      if(!decode_at(script,len,at,d)) {
+        if(undecodable(at)<0) return false;
+        continue;
+      }
+      if(at + d.length > f.end)
+        return fail(at,"%s runs past the end of its function",
+                    opcode_info(d.opcode).name)>0;
+      if(role[at-f.start]==2)
+        return fail(at,"a jump into the middle of an instruction")>0;
+      role[at-f.start] = 1;
+      for(Size i = at+1; i < at+d.length; i++) {
+        if(role[i-f.start]==1)
+          return fail(i,"a jump into the middle of an instruction")>0;
+        role[i-f.start] = 2;
+      }
+      int r = execute(st,d);
+      if(r==FAILED) return false;
+      if(r==STOP) continue;
+      f.stack = std::max(f.stack,(Size)st.stack.size());
+      f.environment = std::max(f.environment,(Size)st.lets.size());
+      f.feedback = std::max(f.feedback,st.feedback);
+
+      OpcodeInfo const & op = opcode_info(d.opcode);
+      Size next[2]; int count = 0;
+      if(!is(op.key,"JMP") && !is(op.key,"JMP16")) next[count++] = at+d.length;
+      if(d.has_target) next[count++] = d.target;
+      for(int i = 0; i < count; i++) {
+        if(next[i] >= f.end)
+          return fail(at,"%s leaves its function",op.name)>0;
+        Frame & b = before[next[i]-f.start];
+        if(!b.reached) { b = st; work.push_back(next[i]); continue; }
+        if(b.stack.size()!=st.stack.size() || b.lets.size()!=st.lets.size() ||
+           b.feedback!=st.feedback)
+          return fail(next[i],"paths meet with different stack depths")>0;
+        bool changed = false;
+        for(Size k = 0; k < st.stack.size(); k++) {
+          Type t = join(b.stack[k],st.stack[k]);
+          if(t!=b.stack[k]) { b.stack[k] = t; changed = true; }
+        }
+        for(Size k = 0; k < st.lets.size(); k++) {
+          Type t = join(b.lets[k],st.lets[k]);
+          if(t!=b.lets[k]) { b.lets[k] = t; changed = true; }
+        }
+        if(changed) work.push_back(next[i]);
+      }
+    }
+    return true;
+  }
+
+  // Work out how deep f goes with its callees; false if it recurses.
+  bool Verifier::total(int i) {
+    Function & f = functions[i];
+    if(f.totalling==2) return true;
+    if(f.totalling==1) return unbounded(f.start,"a recursive function")>0;
+    f.totalling = 1;
+    f.total_stack = f.stack; f.total_environment = f.environment;
+    f.total_callbacks = 0; f.total_feedback = f.feedback;
+    f.reach = f.params;
+    for(Size k = 0; k < f.calls.size(); k++) {
+      CallSite const & c = f.calls[k];
+      if(!total(c.callee)) return false;
+      Function const & g = functions[c.callee];
+      f.total_stack = std::max(f.total_stack,c.stack+g.total_stack);
+      f.total_environment =
+        std::max(f.total_environment,c.environment+g.total_environment);
+      f.total_callbacks = std::max(f.total_callbacks,1+g.total_callbacks);
+      f.total_feedback = std::max(f.total_feedback,c.feedback+g.total_feedback);
+      if(g.reach > c.environment)
+        f.reach = std::max(f.reach,g.reach-c.environment);
+    }
+    f.totalling = 2;
+    return true;
+  }
+
+  void Verifier::run() {
+    bounds.ok = bounds.bounded = true;
+    bounds.stack = bounds.environment = bounds.feedback = 0;
+    bounds.callbacks = bounds.threads = 1;
+    if(!install()) return;
+    for(Size i = 0; i < functions.size(); i++) {
+      current = &functions[i];
+      if(!analyse(functions[i])) return;
+    }
+    current = NULL;
+    for(Size k = 0; k < bounds.threads; k++) { // any thread may be the run
+      int t = globals[globals.size()-1-k];
+      Function & main = functions[t];
+      if(!total(t) || !bounds.bounded) return;
+      if(main.reach) {
+        fail(main.start,"reads %d values below the bottom of the environment",
+             (int)main.reach);
+        return;
+      }
+      bounds.stack = std::max(bounds.stack,main.total_stack);
+      bounds.environment = std::max(bounds.environment,main.total_environment);
+      bounds.callbacks = std::max(bounds.callbacks,1 + main.total_callbacks);
+      bounds.feedback = std::max(bounds.feedback,main.total_feedback);
+    }
+  }
+}
+
+ScriptBounds verify_script(Int8 const * script, Size len) {
+  ScriptBounds bounds;
+  Verifier(script,len,bounds).run();
+  return bounds;
+}
@@ -0,0 +1,38 @@
+/* Static verification of scripts before they are installed
+Copyright (C) 2005-2008, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __VERIFY__
+#define __VERIFY__
+
+#include <string>
+#include <machine.hpp>
+
+// What verify_script found out about a script.  A script is malformed if
+// some path through it underflows a stack, reaches outside the globals,
+// state or exports or below the bottom of the environment, jumps out of
+// its function or into the middle of an instruction, meets another path
+// with a different stack depth, or gives an instruction a value of the
+// wrong type.  (Functions may read the lets of their callers, as compiled
+// lambdas do.)
+//
+// A well-formed script is bounded if, besides, the depth of every stack is
+// known for all runs: all its code could be followed (no platform ops),
+// no function is recursive and every call is to a known function.  The
+// sizes are then exact maxima over installation and every run.
+struct ScriptBounds {
+  bool ok;                  // false if the script is malformed
+  bool bounded;             // are the sizes below exact?
+  std::string error;        // why it is malformed or unbounded
+  Size stack, environment, callbacks, feedback;
+  Size exports, globals, state;  // as declared by DEF_VM or DEF_VM_EX
+  Size threads;             // the last globals, each run as a thread
+};
+
+ScriptBounds verify_script(Int8 const * script, Size len);
+
+#endif // __VERIFY__
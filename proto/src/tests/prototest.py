@@ -159,14 +159,21 @@ class Test():
         self.proto_output = ("","")
 
 
-    def find_dump(self):
-        '''Returns path to the actual dump file with the specified prefix'''
+    def find_dump_dir(self):
+        '''Returns the dump directory, creating it if proto hasn't yet'''
         #Set dump directory (if user hasn't set one already)
         global dump_dir
 
         if not dump_dir:
             current_dir = os.getcwd()
             dump_dir = os.path.join(current_dir,'dumps')
+        if not os.path.isdir(dump_dir):
+            os.makedirs(dump_dir)
+        return dump_dir
+
+    def find_dump(self):
+        '''Returns path to the actual dump file with the specified prefix'''
+        dump_dir = self.find_dump_dir()
         #Filter to find candidates for the dump file
         matches = [x for x in os.listdir(dump_dir) \
                    if x.startswith(self.dumpfile_prefix) and x.endswith('.log')]
@@ -199,6 +206,12 @@ class Test():
         protoarg = protoarg.replace("$(PROTO)", proto_path)
         protoarg = protoarg.replace("$(P2B)", p2b_path)
         protoarg = protoarg.replace("$(DEMOS)", demos_path)
+        # $(DUMP) names a file for proto to write (e.g. a -profile report),
+        # which the assertions then read instead of the dump
+        outfile = None
+        if "$(DUMP)" in protoarg:
+            outfile = os.path.join(self.find_dump_dir(), self.dumpfile_prefix + ".out")
+            protoarg = protoarg.replace("$(DUMP)", outfile)
 
         try:
             #Create process, run & get return code
@@ -207,7 +220,7 @@ class Test():
             if p.returncode != 0:
                 raise subprocess.CalledProcessError(p.returncode, self.protoarg)
             #Find dump file, run assertions
-            dumpfile = self.find_dump()
+            dumpfile = outfile or self.find_dump()
             for a in self.asserts:
                 a.run(dumpfile)
                 if a.failed:
@@ -450,8 +463,10 @@ class ConfigParser():
                 #Generate a dump file name for this test
                 dump_file_name = self.gen_dump_name()
 
-                #Have proto use this dump file name:
-                protoargs = split[1:]
+                #Have proto use this dump file name, and find files named
+                #relative to the test file through $(TESTDIR):
+                test_dir = os.path.dirname(os.path.abspath(self.test_file))
+                protoargs = [a.replace("$(TESTDIR)", test_dir) for a in split[1:]]
                 try:
                     protoargs.insert(protoargs.index("--test-mode -D") + 1,
                                      r"-dump-stem " + dump_file_name)
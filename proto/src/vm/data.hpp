@@ -115,6 +115,38 @@ class Data {
 		inline void reset(Tuple   const & tuple  ) { reset(); value_type = Type_tuple  ; new (&value) Tuple  (tuple  ); } ///< Set the value to a Tuple.
 		inline void reset(Address const & address) { reset(); value_type = Type_address; new (&value) Address(address); } ///< Set the value to an Address.
 		
+		/// Move the value of another Data object into this one, leaving the other one 'undefined'.
+		/**
+		 * Unlike assignment, this does not look at the type of the value, nor touch the reference count of a Tuple.
+		 */
+		inline void take(Data & data) {
+			if (&data == this) return;
+			reset();
+			value_type = data.value_type;
+			value = data.value;
+			data.value_type = Type_undefined;
+		}
+		
+		/// Set the value to a Tuple, moving it out of the given one, which is left empty.
+		/**
+		 * This is how an instruction replaces an operand on the stack with its result in place.
+		 * Unlike reset(), it does not touch the reference count of the Tuple.
+		 */
+		inline void take(Tuple & tuple) {
+			if (value_type != Type_tuple) {
+				reset();
+				value_type = Type_tuple;
+				new (&value) Tuple();
+			}
+			asTuple().swap(tuple);
+		}
+		
+		/// Exchange the values of two Data objects, without copying either.
+		inline void swap(Data & data) {
+			Type  type  = value_type; value_type = data.value_type; data.value_type = type;
+			Value other = value     ; value      = data.value     ; data.value      = other;
+		}
+		
 		/// Make a 'real' copy of the data.
 		/**
 		 * This will copy the contents of a Tuple, instead of sharing them.
@@ -140,15 +172,65 @@ class Data {
 		
 };
 
+/// A stack of Data.
+/**
+ * Values are moved on and off this stack rather than copied where possible,
+ * so that pushing and popping a Tuple does not touch its reference count.
+ */
 template<>
 class Stack<Data> : public BasicStack<Data> {
 	
 	public:
 		inline explicit Stack(Size capacity = 0) : BasicStack<Data>(capacity) {}
 		
-		inline Number  popNumber () { return pop().asNumber();  }
-		inline Tuple   popTuple  () { return pop().asTuple();   }
-		inline Address popAddress() { return pop().asAddress(); }
+		using BasicStack<Data>::push;
+		using BasicStack<Data>::pop;
+		
+		inline void push(Number  const & number ) { emplace().reset(number ); } ///< Push a Number, constructing the Data in place.
+		inline void push(Tuple   const & tuple  ) { emplace().reset(tuple  ); } ///< Push a Tuple, constructing the Data in place.
+		inline void push(Address const & address) { emplace().reset(address); } ///< Push an Address, constructing the Data in place.
+		
+		/// Push the value of a Data object, leaving that one 'undefined'.
+		/**
+		 * \note The Data object must not be an element of this stack.
+		 */
+		inline void pushFrom(Data & data) {
+			emplace().take(data);
+		}
+		
+		/// Pop an element from the stack, moving it out rather than copying it.
+		inline Data pop() {
+			Data element;
+			element.take(peek());
+			pop(1);
+			return element;
+		}
+		
+		/// Pop an element from the stack into the given Data object.
+		inline void popInto(Data & data) {
+			data.take(peek());
+			pop(1);
+		}
+		
+		/// Pop an element from the stack and push it on another one.
+		inline void popOnto(Stack<Data> & stack) {
+			stack.pushFrom(peek());
+			pop(1);
+		}
+		
+		/// Remove the given number of elements from just below the top one, which is kept.
+		/**
+		 * For example, popBelow(2) on the stack <tt>[1 2 3 4]</tt> leaves <tt>[1 4]</tt>.
+		 */
+		inline void popBelow(Size elements) {
+			if (!elements) return;
+			peek(elements).take(peek());
+			pop(elements);
+		}
+		
+		inline Number  popNumber () { Number  number  = peek().asNumber (); pop(1); return number ; }
+		inline Tuple   popTuple  () { Tuple   tuple   = peek().asTuple  (); pop(1); return tuple  ; }
+		inline Address popAddress() { Address address = peek().asAddress(); pop(1); return address; }
 		
 };
 
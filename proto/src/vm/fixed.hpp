@@ -0,0 +1,300 @@
+/*   ____       _  __ _   ____            _
+ *  |  _ \  ___| |/ _| |_|  _ \ _ __ ___ | |_ ___
+ *  | | | |/ _ \ | |_| __| |_) | '__/ _ \| __/ _ \
+ *  | |_| |  __/ |  _| |_|  __/| | ( (_) | |( (_) )
+ *  |____/ \___|_|_|  \__|_|   |_|  \___/ \__\___/
+ *
+ * This file is part of DelftProto.
+ * See COPYING for license details.
+ */
+
+/// \file
+/// Provides the Fixed class and its math functions.
+
+#ifndef __FIXED_HPP
+#define __FIXED_HPP
+
+/// A Q16.16 fixed point number.
+/**
+ * 16 integer bits (including the sign) and 16 fraction bits, held in a 32 bit integer.
+ * This is the Number type when NUMBER_FIXED_POINT is defined, for platforms without a floating point unit.
+ *
+ * Results that do not fit saturate to max() or min(), which also stand in for (minus) infinity.
+ * There is no NaN: what would be NaN (such as 0/0 or the square root of a negative number) is 0.
+ */
+class Fixed {
+
+	public:
+		/// The representation: the value times 2<sup>16</sup>.
+		typedef int Raw;
+
+		/// One, in the representation.
+		static const Raw one = 1 << 16;
+
+		inline Fixed() : raw(0) {}
+		inline Fixed(int           value) : raw(saturate((long long)value * one)) {}
+		inline Fixed(unsigned int  value) : raw(saturate((long long)value * one)) {}
+		inline Fixed(long          value) : raw(saturate((long long)value * one)) {}
+		inline Fixed(unsigned long value) : raw(saturate((long long)value * one)) {}
+		inline Fixed(double        value) : raw(fromDouble(value)) {}
+		inline Fixed(float         value) : raw(fromDouble(value)) {}
+
+		/// Get a Fixed with the given representation.
+		static inline Fixed fromRaw(Raw raw) { Fixed f; f.raw = raw; return f; }
+
+		/// Get the representation.
+		inline Raw toRaw() const { return raw; }
+
+		/// Get the value as a double. Like toRaw(), this is never done implicitly.
+		inline double toDouble() const { return double(raw) / one; }
+
+		static inline Fixed max() { return fromRaw( 0x7FFFFFFF); } ///< The largest Fixed, also used as infinity.
+		static inline Fixed min() { return fromRaw(-0x7FFFFFFF); } ///< The smallest Fixed, also used as minus infinity.
+
+		inline Fixed operator - () const { return fromRaw(-raw); }
+
+		inline Fixed & operator ++ () { return *this += Fixed(1); }
+		inline Fixed & operator -- () { return *this -= Fixed(1); }
+
+		inline Fixed & operator += (Fixed b) { raw = saturate((long long)raw + b.raw); return *this; }
+		inline Fixed & operator -= (Fixed b) { raw = saturate((long long)raw - b.raw); return *this; }
+		inline Fixed & operator *= (Fixed b) { raw = saturate(((long long)raw * b.raw) >> 16); return *this; }
+		inline Fixed & operator /= (Fixed b) {
+			if (b.raw) raw = saturate(((long long)raw << 16) / b.raw);
+			else raw = raw > 0 ? max().raw : raw < 0 ? min().raw : 0;
+			return *this;
+		}
+
+		/// Clamp a wider intermediate result to the representable range.
+		static inline Raw saturate(long long raw) {
+			return raw > 0x7FFFFFFF ? 0x7FFFFFFF : raw < -0x7FFFFFFF ? -0x7FFFFFFF : Raw(raw);
+		}
+
+	protected:
+		Raw raw;
+
+		static inline Raw fromDouble(double value) {
+			double scaled = value * one;
+			if (scaled != scaled) return 0;
+			if (scaled >=  2147483647.0) return max().raw;
+			if (scaled <= -2147483647.0) return min().raw;
+			return saturate((long long)(scaled < 0 ? scaled - 0.5 : scaled + 0.5));
+		}
+
+};
+
+inline Fixed operator + (Fixed a, Fixed b) { return a += b; }
+inline Fixed operator - (Fixed a, Fixed b) { return a -= b; }
+inline Fixed operator * (Fixed a, Fixed b) { return a *= b; }
+inline Fixed operator / (Fixed a, Fixed b) { return a /= b; }
+
+inline bool operator == (Fixed a, Fixed b) { return a.toRaw() == b.toRaw(); }
+inline bool operator != (Fixed a, Fixed b) { return a.toRaw() != b.toRaw(); }
+inline bool operator <  (Fixed a, Fixed b) { return a.toRaw() <  b.toRaw(); }
+inline bool operator <= (Fixed a, Fixed b) { return a.toRaw() <= b.toRaw(); }
+inline bool operator >  (Fixed a, Fixed b) { return a.toRaw() >  b.toRaw(); }
+inline bool operator >= (Fixed a, Fixed b) { return a.toRaw() >= b.toRaw(); }
+
+// Mixed with a built-in number, the other operand is converted to Fixed,
+// as it would be to float. There is an overload for each type Fixed can be
+// made from, so that none is ambiguous with another or with the built-in operators.
+#define FIXED_MIXED_WITH(T, R, op) \
+	inline R operator op (Fixed a, T b) { return a op Fixed(b); } \
+	inline R operator op (T a, Fixed b) { return Fixed(a) op b; }
+#define FIXED_MIXED(R, op) \
+	FIXED_MIXED_WITH(int, R, op) FIXED_MIXED_WITH(unsigned int, R, op) \
+	FIXED_MIXED_WITH(long, R, op) FIXED_MIXED_WITH(unsigned long, R, op) \
+	FIXED_MIXED_WITH(float, R, op) FIXED_MIXED_WITH(double, R, op)
+FIXED_MIXED(Fixed, +) FIXED_MIXED(Fixed, -) FIXED_MIXED(Fixed, *) FIXED_MIXED(Fixed, /)
+FIXED_MIXED(bool, ==) FIXED_MIXED(bool, !=) FIXED_MIXED(bool, <) FIXED_MIXED(bool, <=) FIXED_MIXED(bool, >) FIXED_MIXED(bool, >=)
+#undef FIXED_MIXED
+#undef FIXED_MIXED_WITH
+
+/// \name Fixed point math
+/// Integer-only versions of the \c cmath functions the instructions use.
+/// They work with 30 fraction bits inside, and are accurate to a unit or two in the last (2<sup>-16</sup>) place.
+/// \{
+
+namespace FixedMath {
+
+	/// A number with 30 fraction bits, for the intermediate results.
+	typedef long long Q30;
+
+	const Q30 one     = 1LL << 30;
+	const Q30 pi      = 3373259426LL;
+	const Q30 half_pi = 1686629713LL;
+	const Q30 ln2     =  744261118LL;
+	const Q30 log2e   = 1549082005LL; ///< 1 / ln 2
+
+	inline Q30   up  (Fixed::Raw r) { return (Q30)r << 14; }
+	inline Fixed down(Q30 q) { return Fixed::fromRaw(Fixed::saturate((q + (1 << 13)) >> 14)); }
+
+	/// a times b, for a up to 2<sup>46</sup> (any Fixed, or its base 2 logarithm) and b up to 2<sup>31</sup>, without overflowing.
+	inline Q30 mul(Q30 a, Q30 b) { return ((a >> 16) * b + (((a & 0xFFFF) * b) >> 16)) >> 14; }
+
+	/// The exponent e for which e<sup>a</sup> = 2<sup>e</sup>.
+	inline Q30 exponent(Fixed a) { return ((Q30)a.toRaw() * log2e) >> 16; }
+
+	/// atan(2<sup>-i</sup>), for CORDIC.
+	const Q30 atan_table[30] = {
+		843314857, 497837829, 263043837, 133525159, 67021687, 33543516, 16775851, 8388437,
+		4194283, 2097149, 1048576, 524288, 262144, 131072, 65536, 32768,
+		16384, 8192, 4096, 2048, 1024, 512, 256, 128, 64, 32, 16, 8, 4, 2
+	};
+
+	/// The inverse of the CORDIC gain, 1/K.
+	const Q30 cordic_inverse_gain = 652032874;
+
+	/// 2<sup>2<sup>-k</sup></sup> for k = 1 to 16; beyond that, 1 + 2<sup>-k</sup> ln 2 is as close as 30 bits tell.
+	const Q30 exp2_table[16] = {
+		1518500250, 1276901417, 1170923762, 1121280436, 1097253708, 1085434106, 1079572136, 1076653033,
+		1075196443, 1074468888, 1074105294, 1073923544, 1073832680, 1073787251, 1073764537, 1073753181
+	};
+
+	/// Both sine and cosine of an angle, by rotating (1/K, 0).
+	inline void sincos(Fixed angle, Q30 & s, Q30 & c) {
+		Q30 a = up(angle.toRaw()) % (2 * pi);
+		if (a >  pi) a -= 2 * pi;
+		if (a < -pi) a += 2 * pi;
+		bool flip = false;
+		if (a >  half_pi) { a -= pi; flip = true; }
+		if (a < -half_pi) { a += pi; flip = true; }
+		Q30 x = cordic_inverse_gain, y = 0;
+		for(int i = 0; i < 30; i++){
+			Q30 dx = y >> i, dy = x >> i;
+			if (a >= 0) { x -= dx; y += dy; a -= atan_table[i]; }
+			else        { x += dx; y -= dy; a += atan_table[i]; }
+		}
+		c = flip ? -x : x;
+		s = flip ? -y : y;
+	}
+
+	/// The angle of (x, y), by rotating it onto the x axis; x must be positive.
+	inline Q30 vector_angle(Q30 x, Q30 y) {
+		Q30 angle = 0;
+		for(int i = 0; i < 30; i++){
+			Q30 dx = y >> i, dy = x >> i;
+			if (y > 0) { x += dx; y -= dy; angle += atan_table[i]; }
+			else       { x -= dx; y += dy; angle -= atan_table[i]; }
+		}
+		return angle;
+	}
+
+	/// 2 to the power of e, split into its whole part, a shift, and its fraction.
+	/**
+	 * Past 2<sup>16</sup>, beyond any Fixed, the result stays at 2<sup>16</sup>, so it saturates when brought down.
+	 */
+	inline Q30 exp2_q30(Q30 e) {
+		Q30 whole = e >> 30; // floor
+		if (whole >= 16) return one << 16;
+		if (whole < -31) return 0;
+		// 2^f for the fraction f, one bit at a time.
+		Q30 f = e - (whole << 30), p = one;
+		for(int k = 0; k < 30; k++){
+			if (!(f & (1LL << (29 - k)))) continue;
+			p = (p * (k < 16 ? exp2_table[k] : one + (ln2 >> (k + 1)))) >> 30;
+		}
+		return whole >= 0 ? p << whole : p >> -whole;
+	}
+
+	inline Fixed exp2(Q30 e) { return down(exp2_q30(e)); }
+
+	/// The base 2 logarithm of a positive number.
+	inline Q30 log2(Fixed::Raw r) {
+		Q30 result = 0;
+		unsigned long long v = up(r);
+		while (v >= (unsigned long long)2 * one) { v >>= 1; result += one; }
+		while (v < (unsigned long long)one) { v <<= 1; result -= one; }
+		// v in [1, 2): square repeatedly, taking a fraction bit each time.
+		for(Q30 bit = one >> 1; bit; bit >>= 1){
+			v = (v * v) >> 30;
+			if (v >= (unsigned long long)2 * one) { v >>= 1; result += bit; }
+		}
+		return result;
+	}
+
+}
+
+inline Fixed fabs(Fixed a) { return a < Fixed() ? -a : a; }
+inline Fixed floor(Fixed a) { return Fixed::fromRaw(a.toRaw() & ~0xFFFF); }
+inline Fixed ceil (Fixed a) { return Fixed::fromRaw(Fixed::saturate(((long long)a.toRaw() + 0xFFFF) & ~0xFFFFLL)); }
+inline Fixed rint (Fixed a) {
+	long long r = a.toRaw(), f = r & 0xFFFF, whole = r - f;
+	if (f > 0x8000 || (f == 0x8000 && (whole & 0x10000))) whole += 0x10000; // round half to even, as rint does
+	return Fixed::fromRaw(Fixed::saturate(whole));
+}
+inline Fixed fmod (Fixed a, Fixed b) { return b.toRaw() ? Fixed::fromRaw(a.toRaw() % b.toRaw()) : Fixed(); }
+
+/// Square root, bit by bit on the representation shifted up by 16.
+inline Fixed sqrt(Fixed a) {
+	if (a.toRaw() <= 0) return Fixed();
+	unsigned long long n = (unsigned long long)a.toRaw() << 16, root = 0, bit = 1ULL << 62;
+	while (bit > n) bit >>= 2;
+	while (bit) {
+		if (n >= root + bit) { n -= root + bit; root = (root >> 1) + bit; }
+		else root >>= 1;
+		bit >>= 2;
+	}
+	return Fixed::fromRaw(Fixed::Raw(root));
+}
+
+inline Fixed sin(Fixed a) { FixedMath::Q30 s, c; FixedMath::sincos(a, s, c); return FixedMath::down(s); }
+inline Fixed cos(Fixed a) { FixedMath::Q30 s, c; FixedMath::sincos(a, s, c); return FixedMath::down(c); }
+inline Fixed tan(Fixed a) {
+	FixedMath::Q30 s, c; FixedMath::sincos(a, s, c);
+	if (!c) return s > 0 ? Fixed::max() : Fixed::min();
+	return Fixed::fromRaw(Fixed::saturate((s << 16) / c));
+}
+
+inline Fixed atan2(Fixed y, Fixed x) {
+	FixedMath::Q30 yy = FixedMath::up(y.toRaw()), xx = FixedMath::up(x.toRaw());
+	if (xx == 0 && yy == 0) return Fixed();
+	if (xx > 0) return FixedMath::down(FixedMath::vector_angle(xx, yy));
+	// Turn it a half turn into the right half plane first.
+	FixedMath::Q30 angle = FixedMath::vector_angle(-xx, -yy);
+	return FixedMath::down(angle + (yy >= 0 ? FixedMath::pi : -FixedMath::pi));
+}
+inline Fixed asin(Fixed a) { return atan2(a, sqrt(Fixed(1) - a * a)); }
+inline Fixed acos(Fixed a) { return atan2(sqrt(Fixed(1) - a * a), a); }
+
+/// e<sup>a</sup> = 2<sup>a / ln 2</sup>; saturates above about 10.4, and is 0 below about -11.1.
+inline Fixed exp(Fixed a) { return FixedMath::exp2(FixedMath::exponent(a)); }
+inline Fixed log(Fixed a) {
+	if (a.toRaw() <= 0) return Fixed::min();
+	return FixedMath::down(FixedMath::mul(FixedMath::log2(a.toRaw()), FixedMath::ln2));
+}
+inline Fixed pow(Fixed a, Fixed b) {
+	if (a.toRaw() == 0) return b.toRaw() > 0 ? Fixed() : b.toRaw() == 0 ? Fixed(1) : Fixed::max();
+	if (a.toRaw() < 0) {
+		// Only whole exponents have a real result.
+		if (b.toRaw() & 0xFFFF) return Fixed();
+		Fixed r = pow(-a, b);
+		return (b.toRaw() >> 16) & 1 ? -r : r;
+	}
+	// a^b = 2^(b log2 a), with b split so that the product cannot overflow.
+	FixedMath::Q30 l = FixedMath::log2(a.toRaw());
+	FixedMath::Q30 e = l * (b.toRaw() >> 16) + ((l * (b.toRaw() & 0xFFFF)) >> 16);
+	return FixedMath::exp2(e);
+}
+
+// The hyperbolic functions take e^|a| / 2 = 2^(x - 1) and e^-|a| / 2 = 2^(-x - 1),
+// with x = |a| / ln 2, so that neither half saturates before the result does.
+inline Fixed cosh(Fixed a) {
+	FixedMath::Q30 x = FixedMath::exponent(fabs(a));
+	return FixedMath::down(FixedMath::exp2_q30(x - FixedMath::one) + FixedMath::exp2_q30(-x - FixedMath::one));
+}
+inline Fixed sinh(Fixed a) {
+	FixedMath::Q30 x = FixedMath::exponent(fabs(a));
+	Fixed r = FixedMath::down(FixedMath::exp2_q30(x - FixedMath::one) - FixedMath::exp2_q30(-x - FixedMath::one));
+	return a < Fixed() ? -r : r;
+}
+/// tanh |a| = (1 - e<sup>-2|a|</sup>) / (1 + e<sup>-2|a|</sup>), which only needs e<sup>-2|a|</sup> in (0, 1].
+inline Fixed tanh(Fixed a) {
+	FixedMath::Q30 t = FixedMath::exp2_q30(-2 * FixedMath::exponent(fabs(a)));
+	Fixed r = FixedMath::down(((FixedMath::one - t) << 30) / (FixedMath::one + t));
+	return a < Fixed() ? -r : r;
+}
+
+/// \}
+
+#endif
@@ -31,7 +31,7 @@ class IEEE754binary32 {
 	public:
 		
 		/// Convert from a Number.
-		IEEE754binary32(Number number) : value(number) {}
+		IEEE754binary32(Number number) : value(Number_toDouble(number)) {}
 		
 		/// Convert to a Number.
 		operator Number() { return value; }
@@ -48,7 +48,7 @@ namespace Instructions {
 	 */
 	template<int elements>
 	void LET_N(Machine & machine){
-		for(Index i = 1; i <= elements; i++) machine.environment.push(machine.stack.peek(elements-i));
+		for(Index i = 1; i <= elements; i++) machine.environment.pushFrom(machine.stack.peek(elements-i));
 		machine.stack.pop(elements);
 	}
 	
@@ -61,7 +61,7 @@ namespace Instructions {
 	 */
 	void LET(Machine & machine){
 		Size elements = machine.nextInt();
-		for(Index i = 1; i <= elements; i++) machine.environment.push(machine.stack.peek(elements-i));
+		for(Index i = 1; i <= elements; i++) machine.environment.pushFrom(machine.stack.peek(elements-i));
 		machine.stack.pop(elements);
 	}
 	
@@ -85,4 +85,30 @@ namespace Instructions {
 	
 	/// \}
 	
+	/// \name Environment superinstructions
+	/// \{
+	
+	/// Push the top of the execution stack on the environment stack, leaving it on the execution stack.
+	/**
+	 * Equivalent to <tt>LET_1 REF_0</tt>.
+	 * 
+	 * \param Data The element.
+	 * \return Data The same element.
+	 */
+	void LET_1_REF_0(Machine & machine){
+		machine.environment.push(machine.stack.peek());
+	}
+	
+	/// Move the top of the environment stack to the execution stack.
+	/**
+	 * Equivalent to <tt>REF_0 POP_LET_1</tt>.
+	 * 
+	 * \return Data The element that was on top of the environment stack.
+	 */
+	void REF_0_POP_LET_1(Machine & machine){
+		machine.environment.popOnto(machine.stack);
+	}
+	
+	/// \}
+	
 }
@@ -21,10 +21,9 @@ namespace Instructions {
 	
 	namespace {
 		void INIT_FEEDBACK_set_state(Machine & machine){
-			Data state = machine.stack.pop();
-			Index state_index = machine.stack.popNumber();
-			machine.state[state_index].data = state;
-			machine.stack.push(state);
+			Index state_index = Index(Number_toDouble(machine.stack.peek(1).asNumber()));
+			machine.state[state_index].data = machine.stack.peek();
+			machine.stack.popBelow(1);
 		}
 	}
 	
@@ -41,8 +40,7 @@ namespace Instructions {
 	void INIT_FEEDBACK(Machine & machine){
 		Index state_index = machine.nextInt();
 		Address initialization_function = machine.stack.popAddress();
-		machine.state[state_index].is_executed = true;
-		machine.state[state_index].thread = machine.currentThreadId();
+		machine.claimState(state_index);
 		if (machine.state[state_index].data.isSet()){
 			machine.stack.push(machine.state[state_index].data);
 			machine.firstFeedbackUpdate.push(0);
@@ -64,18 +62,16 @@ namespace Instructions {
 	void SET_FEEDBACK(Machine & machine){
 		Index state_index = machine.nextInt();
 		machine.state[state_index].data = machine.stack.peek();
-		machine.state[state_index].is_executed = true;
+		machine.useState(state_index);
 	}
 #endif
 	
 	/// \deprecated_mitproto
 	void FEEDBACK(Machine & machine){
 		Index state_index = machine.nextInt();
-		Data value = machine.stack.pop();
-		machine.state[state_index].data = value;
-		machine.state[state_index].is_executed = true;
-		machine.stack.pop(1);
-		machine.stack.push(value);
+		machine.state[state_index].data = machine.stack.peek();
+		machine.useState(state_index);
+		machine.stack.popBelow(1);
 		machine.firstFeedbackUpdate.pop();
 	}
 	
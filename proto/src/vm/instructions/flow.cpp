@@ -45,7 +45,7 @@ namespace Instructions {
 		machine.environment.reset(environment_size);
 		machine.    globals.reset(    globals_size);
 		machine.    threads.reset(               1);
-		machine.      state.reset(      state_size);
+		machine.resetState(state_size);
 		machine.       hood.reset(    exports_size);
 		
 		machine.current_thread = 0;
@@ -59,7 +59,6 @@ namespace Instructions {
 	}
 #endif
 	
-#if MIT_COMPATIBILITY != MIT_ONLY
 	/// Define the (extended) VM requirements.
 	/**
 	 * This should be executed before any other instruction.
@@ -77,7 +76,7 @@ namespace Instructions {
 		machine.environment.reset(machine.nextInt());
 		machine.    globals.reset(machine.nextInt());
 		machine.    threads.reset(machine.nextInt());
-		machine.      state.reset(machine.nextInt());
+		machine.resetState(machine.nextInt());
 		machine.       hood.reset(machine.nextInt());
 		
 		machine.current_thread = 0;
@@ -88,7 +87,6 @@ namespace Instructions {
 		machine.callbacks.reset(machine.nextInt());
 		machine.callbacks.push(callback);
 	}
-#endif
 	
 	/// Exit the installation script.
 	/**
@@ -119,9 +117,9 @@ namespace Instructions {
 	 * \return Data The top element.
 	 */
 	void ALL(Machine & machine){
-		Data data = machine.stack.peek();
-		machine.stack.pop(machine.nextInt());
-		machine.stack.push(data);
+		Size elements = machine.nextInt();
+		if (elements) machine.stack.popBelow(elements-1);
+		else machine.stack.push(machine.stack.peek());
 	}
 	
 	/// Waste clockcycles.
@@ -138,20 +136,18 @@ namespace Instructions {
 	 * \return Data The 'false' value when the condition is 0, the 'true' value otherwise.
 	 */
 	void MUX(Machine & machine){
-		Data false_value = machine.stack.pop();
-		Data  true_value = machine.stack.pop();
-		Number condition = machine.stack.popNumber();
-		machine.stack.push(condition ? true_value : false_value);
+		Number condition = machine.stack.peek(2).asNumber();
+		machine.stack.peek(2).take(machine.stack.peek(condition != 0 ? 1 : 0));
+		machine.stack.pop(2);
 	}
 	
 #if MIT_COMPATIBILITY != NO_MIT
 	/// \deprecated_mitproto{MUX}
 	void VMUX(Machine & machine){
 		machine.nextInt8();
-		Data false_value = machine.stack.pop();
-		Data  true_value = machine.stack.pop();
-		Number condition = machine.stack.popNumber();
-		machine.stack.push(condition ? true_value : false_value);
+		Number condition = machine.stack.peek(2).asNumber();
+		machine.stack.peek(2).take(machine.stack.peek(condition != 0 ? 1 : 0));
+		machine.stack.pop(2);
 	}
 #endif
 	
@@ -164,7 +160,7 @@ namespace Instructions {
 	 */
 	void IF(Machine & machine){
 		Size skip = machine.nextInt();
-		if (machine.stack.popNumber()) machine.skip(skip);
+		if (machine.stack.popNumber() != 0) machine.skip(skip);
 	}
 	
 #if MIT_COMPATIBILITY != NO_MIT
@@ -179,7 +175,7 @@ namespace Instructions {
 	 */
 	void IF16(Machine & machine){
 		Size skip = machine.nextInt16();
-		if (machine.stack.popNumber()) machine.skip(skip);
+		if (machine.stack.popNumber() != 0) machine.skip(skip);
 	}
 #endif
 	
@@ -210,10 +206,9 @@ namespace Instructions {
 	namespace {
 		
 		void FUNCALL_end(Machine & machine){
-			Data result    = machine.stack.pop();
-			Size arguments = machine.stack.popNumber();
+			Size arguments = Size(Number_toDouble(machine.stack.peek(1).asNumber()));
 			machine.environment.pop(arguments);
-			machine.stack.push(result);
+			machine.stack.popBelow(1);
 		}
 		
 	}
@@ -229,7 +224,7 @@ namespace Instructions {
 	void FUNCALL_N(Machine & machine){
 		Address function = machine.stack.popAddress();
 		for(Size i = 0; i < arguments; i++){
-			machine.environment.push(machine.stack.peek(arguments-i-1));
+			machine.environment.pushFrom(machine.stack.peek(arguments-i-1));
 		}
 		machine.stack.pop(arguments);
 		machine.stack.push(arguments);
@@ -247,7 +242,7 @@ namespace Instructions {
 		Address function = machine.stack.popAddress();
 		Size arguments = machine.nextInt();
 		for(Size i = 0; i < arguments; i++){
-			machine.environment.push(machine.stack.peek(arguments-i-1));
+			machine.environment.pushFrom(machine.stack.peek(arguments-i-1));
 		}
 		machine.stack.pop(arguments);
 		machine.stack.push(arguments);
@@ -21,33 +21,33 @@ namespace Instructions {
 	
 	/// \deprecated_mitproto
 	void DEF(Machine & machine){
-		machine.globals.push(machine.stack.pop());
+		machine.stack.popOnto(machine.globals);
 	}
 	
 	/// \deprecated_mitproto
 	void DEF_TUP(Machine & machine){
 		machine.execute(FAB_TUP);
-		machine.globals.push(machine.stack.pop());
+		machine.stack.popOnto(machine.globals);
 	}
 	
 	/// \deprecated_mitproto
 	void DEF_VEC(Machine & machine){
 		machine.execute(FAB_VEC);
-		machine.globals.push(machine.stack.pop());
+		machine.stack.popOnto(machine.globals);
 	}
 	
 	/// \deprecated_mitproto
 	template<int elements>
 	void DEF_NUM_VEC_N(Machine & machine){
 		Tuple tuple(elements);
-		for(Index i = 0; i < elements; i++) tuple.push(0);
+		for(Index i = 0; i < elements; i++) tuple.push(Number(0));
 		machine.globals.push(tuple);
 	}
 	
 	/// \deprecated_mitproto
 	void DEF_NUM_VEC(Machine & machine){
 		machine.execute(FAB_NUM_VEC);
-		machine.globals.push(machine.stack.pop());
+		machine.stack.popOnto(machine.globals);
 	}
 	
 	/// Push a global variable on the execution stack.
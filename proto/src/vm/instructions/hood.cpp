@@ -16,11 +16,21 @@
 
 struct HoodInstructions {
 	
+	/// Move on to the next neighbour that has the current import, removing expired neighbours on the way.
+	static void next_neighbour(Machine & machine) {
+		NeighbourHood::iterator & n = machine.current_neighbour;
+		++n;
+		while(n != machine.hood.end()){
+			if (machine.expired(*n)) n = machine.hood.remove(n);
+			else if (!n->imports[machine.current_import].isSet()) ++n;
+			else break;
+		}
+	}
+	
 	static void fold_hood(Machine & machine) {
 		Index import_index = machine.nextInt();
 		Data export_value = machine.stack.pop();
-		Data result = machine.stack.pop();
-		Address fuse = machine.stack.peek().asAddress();
+		Address fuse = machine.stack.peek(1).asAddress();
 		
 		machine.current_import = import_index;
 		
@@ -28,23 +38,21 @@ struct HoodInstructions {
 		
 		machine.current_neighbour = machine.hood.begin();
 		
-		machine.environment.push(result);
-		machine.environment.push(export_value);
+		machine.stack.popOnto(machine.environment);
+		machine.environment.pushFrom(export_value);
 		machine.call(fuse,fold_hood_step);
 	}
 	
 	static void fold_hood_step(Machine & machine) {
 		machine.environment.pop(2);
-		while(++machine.current_neighbour != machine.hood.end() && !machine.current_neighbour->imports[machine.current_import].isSet());
+		next_neighbour(machine);
 		if (machine.current_neighbour != machine.hood.end()){
-			machine.environment.push(machine.stack.pop());
+			machine.stack.popOnto(machine.environment);
 			machine.environment.push(machine.current_neighbour->imports[machine.current_import]);
 			Address fuse = machine.stack.peek().asAddress();
 			machine.call(fuse,fold_hood_step);
 		} else {
-			Data result = machine.stack.pop();
-			machine.stack.pop(1);
-			machine.stack.push(result);
+			machine.stack.popBelow(1);
 		}
 	}
 	
@@ -59,20 +67,18 @@ struct HoodInstructions {
 		
 		machine.current_neighbour = machine.hood.begin();
 		
-		machine.environment.push(export_value);
+		machine.environment.pushFrom(export_value);
 		machine.call(filter,fold_hood_plus_first_filter);
 	}
 	
 	static void fold_hood_filter_next(Machine & machine){
-		while(++machine.current_neighbour != machine.hood.end() && !machine.current_neighbour->imports[machine.current_import].isSet());
+		next_neighbour(machine);
 		if (machine.current_neighbour != machine.hood.end()){
 			machine.environment.push(machine.current_neighbour->imports[machine.current_import]);
 			Address filter = machine.stack.peek(1).asAddress();
 			machine.call(filter,fold_hood_plus_step_filter);
 		} else {
-			Data result = machine.stack.pop();
-			machine.stack.pop(2);
-			machine.stack.push(result);
+			machine.stack.popBelow(2);
 		}
 	}
 	
@@ -83,9 +89,9 @@ struct HoodInstructions {
 	
 	static void fold_hood_plus_step_filter(Machine & machine){
 		machine.environment.pop(1);
-		Data import = machine.stack.pop();
-		machine.environment.push(machine.stack.pop());
-		machine.environment.push(import);
+		machine.environment.pushFrom(machine.stack.peek(1));
+		machine.environment.pushFrom(machine.stack.peek(0));
+		machine.stack.pop(2);
 		Address fuse   = machine.stack.peek(1).asAddress();
 		machine.call(fuse,fold_hood_plus_step_fuse);
 	}
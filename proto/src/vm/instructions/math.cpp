@@ -23,6 +23,10 @@ namespace {
       return a != a;
    }
 
+#ifdef NUMBER_FIXED_POINT
+   bool isNaN(Fixed) { return false; }
+#endif
+
 	Tuple ensureTuple(Data const & d) {
 		if (d.type() == Data::Type_number) {
 			Tuple t(1);
@@ -44,8 +48,8 @@ namespace {
 			Tuple bb = ensureTuple(b);
 			Size size = aa.size() > bb.size() ? aa.size() : bb.size();
 			for(Index i = 0; i < size; i++){
-				Number a_element = i < aa.size() ? aa[i].asNumber() : 0;
-				Number b_element = i < bb.size() ? bb[i].asNumber() : 0;
+				Number a_element = i < aa.size() ? aa[i].asNumber() : Number(0);
+				Number b_element = i < bb.size() ? bb[i].asNumber() : Number(0);
 				if      (isNaN(a_element) 
                        || isNaN(b_element)) return NAN;
             else if (a_element < b_element) return -1;
@@ -105,7 +109,7 @@ namespace Instructions {
 	void LT(Machine & machine){
       float c = compare(machine);
       if (isNaN(c))
-         machine.stack.push(0);
+         machine.stack.push(Number(0));
       else
          machine.stack.push(c == -1 ? 1 : 0);
 	}
@@ -121,7 +125,7 @@ namespace Instructions {
 	void LTE(Machine & machine){
       float c = compare(machine);
       if (isNaN(c))
-         machine.stack.push(0);
+         machine.stack.push(Number(0));
       else
          machine.stack.push(c != 1 ? 1 : 0);
 	}
@@ -137,7 +141,7 @@ namespace Instructions {
 	void GT(Machine & machine){
       float c = compare(machine);
       if (isNaN(c))
-         machine.stack.push(0);
+         machine.stack.push(Number(0));
       else
          machine.stack.push(c == 1 ? 1 : 0);
 	}
@@ -153,7 +157,7 @@ namespace Instructions {
 	void GTE(Machine & machine){
       float c = compare(machine);
       if (isNaN(c))
-         machine.stack.push(0);
+         machine.stack.push(Number(0));
       else
          machine.stack.push(c != -1 ? 1 : 0);
 	}
@@ -165,7 +169,7 @@ namespace Instructions {
 	 */
 	void NOT(Machine & machine){
 		Number a = machine.stack.popNumber();
-		machine.stack.push(a ? 0 : 1);
+		machine.stack.push(a != 0 ? 0 : 1);
 	}
 	
 	/// \}
@@ -182,24 +186,23 @@ namespace Instructions {
 	 * \note If used on tuples, when one of the tuples is shorter, the remaining of the elements will be interpreted as 0.
 	 */
 	void ADD(Machine & machine){
-		Data b = machine.stack.pop();
-		Data a = machine.stack.pop();
+		Data & b = machine.stack.peek(0);
+		Data & a = machine.stack.peek(1);
 		if (a.type() == Data::Type_number && b.type() == Data::Type_number) {
-			Number aa = a.asNumber();
-			Number bb = b.asNumber();
-			machine.stack.push(aa + bb);
+			a.asNumber() += b.asNumber();
 		} else {
 			Tuple aa = ensureTuple(a);
 			Tuple bb = ensureTuple(b);
 			Size size = aa.size() > bb.size() ? aa.size() : bb.size();
 			Tuple result(size);
 			for(Index i = 0; i < size; i++){
-				Number a_element = i < aa.size() ? aa[i].asNumber() : 0;
-				Number b_element = i < bb.size() ? bb[i].asNumber() : 0;
+				Number a_element = i < aa.size() ? aa[i].asNumber() : Number(0);
+				Number b_element = i < bb.size() ? bb[i].asNumber() : Number(0);
 				result.push(a_element + b_element);
 			}
-			machine.stack.push(result);
+			a.take(result);
 		}
+		machine.stack.pop(1);
 	}
 	
 	/// Subtract a number or vector (element-wise) from another one.
@@ -211,24 +214,23 @@ namespace Instructions {
 	 * \note If used on tuples, when one of the tuples is shorter, the remaining of the elements will be interpreted as 0.
 	 */
 	void SUB(Machine & machine){
-		Data b = machine.stack.pop();
-		Data a = machine.stack.pop();
+		Data & b = machine.stack.peek(0);
+		Data & a = machine.stack.peek(1);
 		if (a.type() == Data::Type_number && b.type() == Data::Type_number) {
-			Number aa = a.asNumber();
-			Number bb = b.asNumber();
-			machine.stack.push(aa - bb);
+			a.asNumber() -= b.asNumber();
 		} else {
 			Tuple aa = ensureTuple(a);
 			Tuple bb = ensureTuple(b);
 			Size size = aa.size() > bb.size() ? aa.size() : bb.size();
 			Tuple result(size);
 			for(Index i = 0; i < size; i++){
-				Number a_element = i < aa.size() ? aa[i].asNumber() : 0;
-				Number b_element = i < bb.size() ? bb[i].asNumber() : 0;
+				Number a_element = i < aa.size() ? aa[i].asNumber() : Number(0);
+				Number b_element = i < bb.size() ? bb[i].asNumber() : Number(0);
 				result.push(a_element - b_element);
 			}
-			machine.stack.push(result);
+			a.take(result);
 		}
+		machine.stack.pop(1);
 	}
 	
 	/// Multiply a number or vector (element-wise) with a number.
@@ -238,19 +240,18 @@ namespace Instructions {
 	 * \return \m{a \cdot b}
 	 */
 	void MUL(Machine & machine){
-		Data b = machine.stack.pop();
-		Data a = machine.stack.pop();
+		Data & b = machine.stack.peek(0);
+		Data & a = machine.stack.peek(1);
 		if (a.type() == Data::Type_number && b.type() == Data::Type_number) {
-			Number aa = a.asNumber();
-			Number bb = b.asNumber();
-			machine.stack.push(aa * bb);
+			a.asNumber() *= b.asNumber();
 		} else {
 			Number        factor = a.type() == Data::Type_number ? a.asNumber() : b.asNumber();
 			Tuple const & vector = a.type() == Data::Type_number ? b.asTuple () : a.asTuple ();
 			Tuple result(vector.size());
 			for(Index i = 0; i < vector.size(); i++) result.push(vector[i].asNumber() * factor);
-			machine.stack.push(result);
+			a.take(result);
 		}
+		machine.stack.pop(1);
 	}
 	
 	/// Divide a number or vector (element-wise) by another.
@@ -260,17 +261,18 @@ namespace Instructions {
 	 * \return \m{\frac a b}
 	 */
 	void DIV(Machine & machine){
-		Data b = machine.stack.pop();
-		Data a = machine.stack.pop();
+		Data & b = machine.stack.peek(0);
+		Data & a = machine.stack.peek(1);
 		if (a.type() == Data::Type_number) {
-			machine.stack.push(a.asNumber() / b.asNumber());
+			a.asNumber() /= b.asNumber();
 		} else {
 			Number        divisor = b.asNumber();
 			Tuple const & vector  = a.asTuple ();
 			Tuple result(vector.size());
 			for(Index i = 0; i < vector.size(); i++) result.push(vector[i].asNumber() / divisor);
-			machine.stack.push(result);
+			a.take(result);
 		}
+		machine.stack.pop(1);
 	}
 	
 	/// Multiply two vectors (element-wise).
@@ -285,8 +287,8 @@ namespace Instructions {
 		Size size = a.size() > b.size() ? a.size() : b.size();
 		Tuple result(size);
 		for(Index i = 0; i < size; i++){
-			Number a_element = i < a.size() ? a[i].asNumber() : 0;
-			Number b_element = i < b.size() ? b[i].asNumber() : 0;
+			Number a_element = i < a.size() ? a[i].asNumber() : Number(0);
+			Number b_element = i < b.size() ? b[i].asNumber() : Number(0);
 			result.push(a_element * b_element);
 		}
 		machine.stack.push(result);
@@ -294,6 +296,141 @@ namespace Instructions {
 	
 	/// \}
 	
+	/// \name Number-only instructions
+	/// These are emitted instead of their generic counterparts when the compiler has proven that both operands are numbers.
+	/// They skip the type checks and update the top of the stack in place.
+	/// \{
+	
+	/// Add two numbers.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{a + b}
+	 */
+	void NUM_ADD(Machine & machine){
+		Number b = machine.stack.popNumber();
+		machine.stack.peek().asNumber() += b;
+	}
+	
+	/// Subtract a number from another.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{a - b}
+	 */
+	void NUM_SUB(Machine & machine){
+		Number b = machine.stack.popNumber();
+		machine.stack.peek().asNumber() -= b;
+	}
+	
+	/// Multiply two numbers.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{a \cdot b}
+	 */
+	void NUM_MUL(Machine & machine){
+		Number b = machine.stack.popNumber();
+		machine.stack.peek().asNumber() *= b;
+	}
+	
+	/// Divide a number by another.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{\frac a b}
+	 */
+	void NUM_DIV(Machine & machine){
+		Number b = machine.stack.popNumber();
+		machine.stack.peek().asNumber() /= b;
+	}
+	
+	/// Check if a number is less than another one.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{\left\lbrace\begin{array}{ll}1&a<b\\0&a\geq b\end{array}\right.}
+	 */
+	void NUM_LT(Machine & machine){
+		Number b = machine.stack.popNumber();
+		Number & a = machine.stack.peek().asNumber();
+		a = a < b ? 1 : 0;
+	}
+	
+	/// Check if a number is less than or equal to another one.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{\left\lbrace\begin{array}{ll}1&a\leq b\\0&a>b\end{array}\right.}
+	 */
+	void NUM_LTE(Machine & machine){
+		Number b = machine.stack.popNumber();
+		Number & a = machine.stack.peek().asNumber();
+		a = a <= b ? 1 : 0;
+	}
+	
+	/// Check if a number is greater than another one.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{\left\lbrace\begin{array}{ll}1&a>b\\0&a\leq b\end{array}\right.}
+	 */
+	void NUM_GT(Machine & machine){
+		Number b = machine.stack.popNumber();
+		Number & a = machine.stack.peek().asNumber();
+		a = a > b ? 1 : 0;
+	}
+	
+	/// Check if a number is greater than or equal to another one.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{\left\lbrace\begin{array}{ll}1&a\geq b\\0&a<b\end{array}\right.}
+	 */
+	void NUM_GTE(Machine & machine){
+		Number b = machine.stack.popNumber();
+		Number & a = machine.stack.peek().asNumber();
+		a = a >= b ? 1 : 0;
+	}
+	
+	/// Check if two numbers are equal.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{\left\lbrace\begin{array}{ll}1&a=b\\0&a\neq b\end{array}\right.}
+	 */
+	void NUM_EQ(Machine & machine){
+		Number b = machine.stack.popNumber();
+		Number & a = machine.stack.peek().asNumber();
+		a = a == b ? 1 : 0;
+	}
+	
+	/// Get the maximum of two numbers.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{\max\lbrace a\,b\rbrace}
+	 */
+	void NUM_MAX(Machine & machine){
+		Number b = machine.stack.popNumber();
+		Number & a = machine.stack.peek().asNumber();
+		if (!(a > b)) a = b;
+	}
+	
+	/// Get the minimum of two numbers.
+	/**
+	 * \param Number \m{a}
+	 * \param Number \m{b}
+	 * \return \m{\min\lbrace a\,b\rbrace}
+	 */
+	void NUM_MIN(Machine & machine){
+		Number b = machine.stack.popNumber();
+		Number & a = machine.stack.peek().asNumber();
+		if (!(a < b)) a = b;
+	}
+	
+	/// \}
+	
 	/// \name Math function instructions
 	/// \{
 	
@@ -327,9 +464,8 @@ namespace Instructions {
 	 * \note If used on tuples, when one of the tuples is shorter, the remaining of the elements will be interpreted as 0.
 	 */
 	void MAX(Machine & machine){
-		Data b = machine.stack.pop();
-		Data a = machine.stack.pop();
-		machine.stack.push(compare(a,b) > 0 ? a : b);
+		if (compare(machine.stack.peek(1),machine.stack.peek(0)) > 0) machine.stack.pop(1);
+		else machine.stack.popBelow(1);
 	}
 	
 	/// Get the (lexicographical) minimum of two numbers or vectors.
@@ -341,9 +477,8 @@ namespace Instructions {
 	 * \note If used on tuples, when one of the tuples is shorter, the remaining of the elements will be interpreted as 0.
 	 */
 	void MIN(Machine & machine){
-		Data b = machine.stack.pop();
-		Data a = machine.stack.pop();
-		machine.stack.push(compare(a,b) < 0 ? a : b);
+		if (compare(machine.stack.peek(1),machine.stack.peek(0)) < 0) machine.stack.pop(1);
+		else machine.stack.popBelow(1);
 	}
 	
 	/// Get a number to the power of another.
@@ -548,8 +683,8 @@ namespace Instructions {
 			Size size = a.size() > b.size() ? a.size() : b.size();
 			Tuple result(size);
 			for(Index i = 0; i < size; i++){
-				Number a_element = i < a.size() ? a[i].asNumber() : 0;
-				Number b_element = i < b.size() ? b[i].asNumber() : 0;
+				Number a_element = i < a.size() ? a[i].asNumber() : Number(0);
+				Number b_element = i < b.size() ? b[i].asNumber() : Number(0);
 				result.push(Random::number(a_element, b_element));
 			}
 			machine.stack.push(result);
@@ -22,11 +22,9 @@ namespace Instructions {
 	
 	namespace {
 		void apply_end(Machine & machine){
-			Data result = machine.stack.pop();
-			Tuple arguments = machine.stack.popTuple();
-			machine.stack.popAddress();
-			machine.stack.push(result);
-			machine.environment.pop(arguments.size());
+			Size arguments = machine.stack.peek(1).asTuple().size();
+			machine.stack.popBelow(2);
+			machine.environment.pop(arguments);
 		}
 	}
 	
@@ -55,10 +53,7 @@ namespace Instructions {
 				Address filter = machine.stack.peek(2).asAddress();
 				machine.call(filter, map_step);
 			} else {
-				Data result = machine.stack.popTuple();
-				machine.stack.popTuple();
-				machine.stack.popAddress();
-				machine.stack.push(result);
+				machine.stack.popBelow(2);
 			}
 		}
 	}
@@ -103,14 +98,12 @@ namespace Instructions {
 			Tuple   & fold_values = machine.stack.peek(1).asTuple  ();
 			Address & fold_fuse   = machine.stack.peek(2).asAddress();
 			if (++fold_index < fold_values.size()){
-				machine.environment.push(result);
-				machine.environment.push(fold_values[Index(fold_index)]);
+				machine.environment.pushFrom(result);
+				machine.environment.push(fold_values[Index(Number_toDouble(fold_index))]);
 				machine.call(fold_fuse, fold_step);
 			} else {
-				machine.stack.popNumber();
-				machine.stack.popTuple();
-				machine.stack.popAddress();
-				machine.stack.push(result);
+				machine.stack.pop(3);
+				machine.stack.pushFrom(result);
 			}
 		}
 	}
@@ -148,12 +141,12 @@ namespace Instructions {
 		Address fold_fuse   = machine.stack.peek().asAddress();
 		
 		if (fold_values.empty()){
-			machine.stack.popAddress();
-			machine.stack.push(result);
+			machine.stack.pop(1);
+			machine.stack.pushFrom(result);
 		} else {
 			machine.stack.push(fold_values);
-			machine.stack.push(0);
-			machine.environment.push(result);
+			machine.stack.push(Number(0));
+			machine.environment.pushFrom(result);
 			machine.environment.push(fold_values[0]);
 			machine.call(fold_fuse, fold_step);
 		}
@@ -36,7 +36,7 @@ namespace Instructions {
 				return;
 			}
 		}
-		if (machine.currentThread().last_time) {
+		if (machine.currentThread().last_time != 0) {
 			dt = machine.startTime() - machine.currentThread().last_time;
 		} else {
 			dt = machine.currentThread().desired_period;
@@ -46,16 +46,15 @@ namespace Instructions {
 	
 	/// Set the desired period of a thread.
 	/**
-	 * Set the minimum period for this thread.
+	 * Set the minimum period for this thread: the scheduler will not run it again until this much time has passed.
 	 * 
-	 * \warning Currently, the scheduler ignores this setting.
+	 * \see Thread::due()
 	 */
 	void SET_DT(Machine & machine){
 		Number dt = machine.stack.peek().asNumber();
-		machine.currentThread().desired_period = dt;
+		machine.currentThread().setPeriod(dt);
 	}
 	
-#if MIT_COMPATIBILITY != MIT_ONLY
 	/// Activate this or another Thread.
 	/**
 	 * \see Thread::activate()
@@ -99,7 +98,6 @@ namespace Instructions {
 		machine.stack.push(machine.threads[thread].result);
 	}
 	
-#endif
 	/// \}
 	
 }
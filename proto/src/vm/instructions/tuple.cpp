@@ -26,7 +26,7 @@ namespace Instructions {
 	 * \return Data The element.
 	 */
 	void ELT(Machine & machine){
-		Index element = machine.stack.popNumber();
+		Index element = Index(Number_toDouble(machine.stack.popNumber()));
 		Tuple  tuple  = machine.stack.popTuple ();
 		machine.stack.push(tuple[element]);
 	}
@@ -87,7 +87,7 @@ namespace Instructions {
 	void FAB_NUM_VEC(Machine & machine){
 		Size elements = machine.nextInt();
 		Tuple tuple(elements);
-		for(Index i = 0; i < elements; i++) tuple.push(0);
+		for(Index i = 0; i < elements; i++) tuple.push(Number(0));
 		machine.stack.push(tuple);
 	}
 	
@@ -103,6 +103,44 @@ namespace Instructions {
 		machine.stack.push(a.type() == Data::Type_number ? 1 : a.asTuple().size());
 	}
 	
+	/// Add two vectors of the same, fixed size (element-wise).
+	/**
+	 * Emitted instead of ADD when the compiler has proven both operands are vectors of size \p n.
+	 * The result is written over \m{\vec a}, which is only copied first if its contents are shared.
+	 *
+	 * \tparam n The size of both vectors.
+	 * \param Tuple \m{\vec a}
+	 * \param Tuple \m{\vec b}
+	 * \return Tuple \m{\vec a + \vec b}
+	 */
+	template<int n>
+	void VEC_ADD_N(Machine & machine){
+		Tuple const & b = machine.stack.peek(0).asTuple();
+		Tuple       & a = machine.stack.peek(1).asTuple();
+		a.detach();
+		for(Index i = 0; i < n; i++) a[i].asNumber() += b[i].asNumber();
+		machine.stack.pop(1);
+	}
+	
+	/// Subtract a vector from another of the same, fixed size (element-wise).
+	/**
+	 * Emitted instead of SUB when the compiler has proven both operands are vectors of size \p n.
+	 * The result is written over \m{\vec a}, which is only copied first if its contents are shared.
+	 *
+	 * \tparam n The size of both vectors.
+	 * \param Tuple \m{\vec a}
+	 * \param Tuple \m{\vec b}
+	 * \return Tuple \m{\vec a - \vec b}
+	 */
+	template<int n>
+	void VEC_SUB_N(Machine & machine){
+		Tuple const & b = machine.stack.peek(0).asTuple();
+		Tuple       & a = machine.stack.peek(1).asTuple();
+		a.detach();
+		for(Index i = 0; i < n; i++) a[i].asNumber() -= b[i].asNumber();
+		machine.stack.pop(1);
+	}
+	
 #if MIT_COMPATIBILITY != NO_MIT
 	/// \deprecated_mitproto{ADD}
 	void VADD(Machine & machine){
@@ -157,8 +195,8 @@ namespace Instructions {
 	void VSLICE(Machine & machine){
 		machine.nextInt8();
 		Tuple source = machine.stack.popTuple();
-		Index start = machine.stack.popNumber();
-		Index stop  = machine.stack.popNumber();
+		Index start = Index(Number_toDouble(machine.stack.popNumber()));
+		Index stop  = Index(Number_toDouble(machine.stack.popNumber()));
 		start = start >= 0 ? start : source.size() + start;
 		stop  = stop  >= 0 ? stop  : source.size() + stop ;
 		Tuple result(stop-start);
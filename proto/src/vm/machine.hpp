@@ -110,6 +110,18 @@ class BasicMachine {
 		/** \memberof Machine */
 		Index current_import;
 		
+		/// The thread each state variable belongs to: the one that last initialized it.
+		/** \memberof Machine */
+		Array<Thread::Id> state_threads;
+		
+		/// Whether each state variable was used so far in the current run.
+		/** \memberof Machine */
+		Array<bool> state_executed;
+		
+		/// The state variables used so far in the current run, each listed once.
+		/** \memberof Machine */
+		Stack<Index> executed_states;
+		
 	public:
 		
 		/// The constructor.
@@ -185,6 +197,35 @@ class BasicMachine {
 			
 		/// \}
 		
+		/// \name State
+		/// \{
+			
+			/// Allocate the given number of state variables, all unset.
+			/** \memberof Machine */
+			inline void resetState(Size size) {
+				state.reset(size);
+				state_threads.reset(size);
+				state_executed.reset(size);
+				executed_states.reset(size);
+			}
+			
+			/// Mark a state variable as used in the current run, so that it is kept.
+			/** \memberof Machine */
+			inline void useState(Index index) {
+				if (state_executed[index]) return;
+				state_executed[index] = true;
+				executed_states.push(index);
+			}
+			
+			/// Make a state variable belong to the current thread, and mark it as used.
+			/** \memberof Machine */
+			inline void claimState(Index index) {
+				state_threads[index] = current_thread;
+				useState(index);
+			}
+			
+		/// \}
+		
 		/// \name Low level
 		/// \{
 			
@@ -257,6 +298,17 @@ class BasicMachine {
 				return *hood.begin();
 			}
 			
+			/// Check whether a neighbour's data is too old to be used.
+			/**
+			 * The hood instructions drop expired neighbours as they come across them.
+			 * You can override this function by \ref extending the Machine class.
+			 * By default, neighbours never expire.
+			 */
+			/** \memberof Machine */
+			inline bool expired(Neighbour const & neighbour) const {
+				return false;
+			}
+			
 			inline void print_stack(Stack<Data> *s) {
 				if (s->empty()) {
 				  cout << " Empty " << endl;
@@ -272,7 +324,7 @@ class BasicMachine {
 
 			inline void print_data(Data el) {
 			  if (el.type() == Data::Type_number) {
-				cout << el.asNumber();
+				cout << Number_toDouble(el.asNumber());
 			  } else if (el.type() == Data::Type_address) {
 				cout << "A:" << (int)*(el.asAddress());
 			  } else if (el.type() == Data::Type_tuple) {
@@ -337,41 +389,96 @@ class Machine : public ExtendedMachine {
 				callbacks.push(0);
 			}
 			
+			/// Check whether any thread is due to run in a run starting at the given time.
+			/**
+			 * When none is, run() would not run anything: a platform can skip the run altogether.
+			 * 
+			 * \see Thread::due()
+			 */
+			inline bool due(Time start) const {
+				for(Size i = 0; i < threads.size(); i++){
+					if (threads[i].due(start)) return true;
+				}
+				return false;
+			}
+			
 			/// Start the next scheduled task.
 			/**
+			 * Threads are run Round-robin style, skipping the ones that are not due.
+			 * A platform that keeps starting runs at the same time for as long as due() says so runs every thread due then, each once.
+			 * 
 			 * \note This does not execute Proto code, it only prepares the next run. Call step() while not finished() to execute it.
 			 * 
 			 * \param start The time at the start of this run.
 			 */
 			inline void run(Time start) {
+				if (!start_thread(start)) return;
+				jump(globals.peek(current_thread).asAddress());
+				callbacks.push(run_callback);
+			}
+			
+			/// Take the place of run() for a run known to compute what the thread's last run did.
+			/**
+			 * The thread run() would start is chosen and accounted for as if it had run, without executing any Proto code:
+			 * its result and the state are left as its last run left them.
+			 * 
+			 * \param start The time at the start of this run.
+			 */
+			inline void skip_run(Time start) {
+				if (!start_thread(start)) return;
+				threads[current_thread].last_time = start;
+				threads[current_thread].has_run = true;
+				current_thread++;
+				if (current_thread >= threads.size()) current_thread = 0;
+			}
+			
+			/** \cond */
+		protected:
+			// Choose the thread for a run starting at the given time, round-robin from the current one,
+			// and take its trigger. False if no thread is due.
+			inline bool start_thread(Time start) {
 				start_time = start;
 				for(Size i = 0; i < threads.size(); i++){
-					if (threads[current_thread].pending()){
+					if (threads[current_thread].due(start)){
 						threads[current_thread].untrigger();
-						jump(globals.peek(current_thread).asAddress());
-						callbacks.push(run_callback);
-						return;
+						return true;
 					}
 					current_thread++;
 					if (current_thread >= threads.size()) current_thread = 0;
 				}
+				return false;
 			}
 			
-			/** \cond */
-		protected:
 			static void run_callback(Machine & machine){
 				machine.threads[machine.current_thread].result = machine.stack.pop();
 				machine.threads[machine.current_thread].last_time = machine.startTime();
-				for(Size i = 0; i < machine.state.size(); i++){
-					if (machine.state[i].thread == machine.current_thread){
-						if (!machine.state[i].is_executed) machine.state[i].data.reset();
-						machine.state[i].is_executed = false;
-					}
-				}
+				machine.threads[machine.current_thread].has_run = true;
+				machine.retire_states(machine.threads[machine.current_thread]);
 				machine.current_thread++;
 				if (machine.current_thread >= machine.threads.size()) machine.current_thread = 0;
 			}
 			
+			// Reset the state variables of the thread that used them in its last run but not in this one,
+			// and remember the ones used in this run for the next.
+			// Only the variables used in either run are touched, not the whole state.
+			inline void retire_states(Thread & thread){
+				if (thread.used_states.size() != state.size()){
+					thread.used_states.reset(state.size());
+					thread.used_state_count = 0;
+				}
+				for(Size i = 0; i < thread.used_state_count; i++){
+					Index s = thread.used_states[i];
+					if (!state_executed[s] && state_threads[s] == current_thread) state[s].data.reset();
+				}
+				thread.used_state_count = 0;
+				for(Size i = 0; i < executed_states.size(); i++){
+					Index s = executed_states[i];
+					state_executed[s] = false;
+					if (state_threads[s] == current_thread) thread.used_states[thread.used_state_count++] = s;
+				}
+				executed_states.pop(executed_states.size());
+			}
+			
 			/** \endcond */
 			
 		public:
@@ -386,6 +493,21 @@ class Machine : public ExtendedMachine {
 				else execute_unknown(opcode);
 			}
 			
+			/// Execute the next instruction, which the caller has already looked up.
+			/**
+			 * Lets a caller that steps several machines through the same script decode each instruction once for all of them.
+			 * 
+			 * \param opcode The opcode at instruction_pointer.
+			 * \param i Its entry in \ref instructions.
+			 * 
+			 * \note Do not use this function when already finished().
+			 */
+			inline void step(Int8 opcode, Instruction i) {
+				instruction_pointer++;
+				if (i) execute(i);
+				else execute_unknown(opcode);
+			}
+			
 			/// Check whether the running script (installation or a single run) has finished (true) or not (false).
 			inline bool finished() {
 				return callbacks.empty();
@@ -434,9 +556,7 @@ class Machine : public ExtendedMachine {
 		/// \}
 		
 		friend void Instructions::DEF_VM(Machine &);
-#if MIT_COMPATIBILITY != MIT_ONLY
 		friend void Instructions::DEF_VM_EX(Machine &);
-#endif
 		friend void Instructions::EXIT(Machine &);
 		friend class HoodInstructions;
 		
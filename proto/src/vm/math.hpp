@@ -16,6 +16,9 @@
  * This file simply includes the standard \c cmath header.
  * Implementations can \ref fileoverloading "overload this file"
  * if the corresponding platform does provide this header.
+ *
+ * With NUMBER_FIXED_POINT, the fixed point versions from fixed.hpp are used for Number.
  */
 
 #include <cmath>
+#include <types.hpp>
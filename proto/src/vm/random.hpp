@@ -33,7 +33,7 @@ class Random {
 		 * \return A random Number between min and max.
 		 */
 		static Number number(Number min, Number max) {
-			return Number(std::rand()) / Number(RAND_MAX) * (max - min) + min;
+			return Number(float(std::rand()) / float(RAND_MAX)) * (max - min) + min;
 		}
 		
 };
@@ -138,6 +138,25 @@ class SharedVector {
 			return *this;
 		}
 		
+		/// Exchange the contents of two vectors, without touching their reference counts.
+		inline void swap(SharedVector & vector) {
+			VectorData * other = data;
+			data = vector.data;
+			vector.data = other;
+		}
+		
+		/// Make sure the contents are not shared with any other instance, so they can be changed in place.
+		/**
+		 * If they are shared, this instance first gets its own copy of them.
+		 */
+		inline void detach() {
+			if (data->references() > 1){
+				VectorData * own = new (Memory<VectorData>::allocate()) VectorData(*data);
+				data->release();
+				data = own;
+			}
+		}
+		
 		/// Create a copy of this vector.
 		/**
 		 * All elements will be copied using their own copy constructor.
@@ -72,6 +72,11 @@ class BasicStack {
 			new (top++) Element(element);
 		}
 		
+		/// Push a default-constructed element on the stack, to be filled in place.
+		inline Element & emplace() {
+			return *new (top++) Element();
+		}
+		
 		/// Pop an element from the stack.
 		inline Element pop() {
 			Element element = *--top;
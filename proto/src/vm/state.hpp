@@ -15,10 +15,12 @@
 #define __STATE_HPP
 
 #include <data.hpp>
-#include <thread.hpp>
 
 /// A state variable.
 /**
+ * A state variable belongs to the thread that last initialized it. When it is not used in a run of that thread, it is reset by the machine.
+ * Which thread it belongs to and whether it was used are kept by the Machine, next to Machine::state, so that a State is no larger than its Data.
+ * 
  * \see Instructions::INIT_FEEDBACK
  * \see Instructions::FEEDBACK
  */
@@ -28,18 +30,6 @@ class State {
 		/// The data contained in this state variable.
 		Data data;
 		
-		/// A boolean indicating wheter this state variable was used in the last round (true) or not (false).
-		/**
-		 * When a state variable is not used in a run of the thread this state variable belongs to, it is reset by the machine.
-		 */
-		bool is_executed;
-		
-		/// The thread that this state variable belongs to.
-		Thread::Id thread;
-		
-		/// The default constructor.
-		State() : is_executed(false) {}
-		
 };
 
 #endif
@@ -17,6 +17,7 @@
 #include <types.hpp>
 #include <data.hpp>
 #include <time.hpp>
+#include <array.hpp>
 
 class BasicThread {
 	
@@ -32,16 +33,29 @@ class BasicThread {
 		/// The desired period for this thread.
 		/** \memberof Thread */
 		/**
-		 * \warning This variable is currently not used in the scheduler.
+		 * Once set with setPeriod(), the scheduler runs this thread no more often than this.
 		 */
-		Time desired_period; //TODO: Use this in the scheduler.
+		Time desired_period;
 		
 	protected:
 		bool is_triggered;
 		bool is_active;
 		
+		/// Whether desired_period was set, and so limits how often this thread runs.
+		/** \memberof Thread */
+		bool has_period;
+		
+		/// Whether this thread has run at all.
+		/** \memberof Thread */
+		bool has_run;
+		
+		/// The state variables that belonged to this thread and were used in its last run.
+		/** \memberof Thread */
+		Array<Index> used_states;
+		Size used_state_count;
+		
 	public:
-		BasicThread() : desired_period(1) {} //TODO: Find a better way to get a value for desired_period.
+		BasicThread() : last_time(0), desired_period(1), is_triggered(false), is_active(false), has_period(false), has_run(false), used_state_count(0) {} //TODO: Find a better way to get a value for desired_period.
 		
 		/// Trigger this thread.
 		/**
@@ -82,6 +96,31 @@ class BasicThread {
 			return is_active || is_triggered;
 		}
 		
+		/// Set the desired period of this thread.
+		/**
+		 * From now on, the thread will not run again until this much time has passed since its last run.
+		 */
+		/** \memberof Thread */
+		void setPeriod(Time period) {
+			desired_period = period;
+			has_period = true;
+		}
+		
+		/// Check whether this thread is due to run in a run starting at the given time.
+		/**
+		 * A pending thread is due unless it already ran in a run starting at this time,
+		 * or it has a desired period that has not yet passed since its last run.
+		 * (A thousandth of the period is allowed for rounding in the clock.)
+		 */
+		/** \memberof Thread */
+		bool due(Time now) const {
+			if (!pending()) return false;
+			if (!has_run) return true;
+			if (now == last_time) return false;
+			if (!has_period) return true;
+			return now - last_time >= desired_period - desired_period / 1000;
+		}
+		
 		/// The result of the last execution of this thread.
 		/** \memberof Thread */
 		Data result;
@@ -17,6 +17,8 @@
 #ifndef __TYPES_HPP
 #define __TYPES_HPP
 
+#include "config.h"
+
 /// \class Size
 /// Used to represent sizes/counts of things in memory.
 typedef size_t Size;
@@ -49,13 +51,36 @@ typedef unsigned char Alignment;
  * \brief A floating point number.
  * 
  * One of the types that can be stored in Data.
+ *
+ * When NUMBER_FIXED_POINT is defined (\c configure \c --enable-fixed-point),
+ * this is the Q16.16 Fixed instead, for platforms without a floating point unit.
  */
+#ifdef NUMBER_FIXED_POINT
+#include <fixed.hpp>
+typedef Fixed Number;
+#else
 typedef float Number;
+#endif
 
 /// \var Number_infinity
 /// A Number representing infinity.
 namespace {
+#ifdef NUMBER_FIXED_POINT
+	const Number Number_infinity = Fixed::max();
+#else
 	const Number Number_infinity = std::numeric_limits<Number>::infinity();
+#endif
 }
 
+/// A Number as a double.
+/**
+ * Fixed does not convert implicitly, so wherever a Number is printed or used
+ * as a float, an index or a count, it goes through here.
+ */
+#ifdef NUMBER_FIXED_POINT
+inline double Number_toDouble(Number number) { return number.toDouble(); }
+#else
+inline double Number_toDouble(Number number) { return number; }
+#endif
+
 #endif